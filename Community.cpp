@@ -14,15 +14,23 @@
 #include "Person.h"
 #include "Mosquito.h"
 #include "Location.h"
+#include "LocationRanking.h"
 #include "Community.h"
 #include "Parameters.h"
 #include "Date.h"
+#include "Instrumentation.h"
+#include "Metrics.h"
+#include "TransmissionChain.h"
+#include "Forcing.h"
 
 using namespace dengue::standard;
 
 const Parameters* Community::_par;
 vector< set<Location*, LocPtrComp> > Community::_isHot;
-set<Person*> Community::_revaccinate_set;
+vector< vector<Person*> > Community::_vaccineDoseCalendar;
+map<int, vector<Person*> > Community::_catchupVaccinationQueue;
+vector< set<Location*, LocPtrComp> > Community::_vectorControlStartDates;
+set<Location*, LocPtrComp> Community::_vectorControlLocations;
 vector<Person*> Community::_peopleByAge;
 map<int, set<pair<Person*,Person*> > > Community::_delayedBirthdays;
 
@@ -41,14 +49,22 @@ Community::Community(const Parameters* parameters) :
     {
     _par = parameters;
     _nDay = 0;
+    _chain = nullptr;
+    _forcing = nullptr;
+    _tickPhases = nullptr;
+    _tickFeatures = 0;
     _fMosquitoCapacityMultiplier = 1.0;
     _expectedEIP = -1;
     _EIP_emu = -1;
     _fMortality = NULL;
     _bNoSecondaryTransmission = false;
     _uniformSwap = true;
+    _burdenRanking = nullptr;
+    _reactiveResponses.resize(_par->reactiveInterventions.size());
     for (int a = 0; a<NUM_AGE_CLASSES; a++) _nPersonAgeCohortSizes[a] = 0;
     _isHot.resize(_par->nRunLength);
+    _vaccineDoseCalendar.resize(_par->nRunLength);
+    _vectorControlStartDates.resize(_par->nRunLength);
 }
 
 
@@ -64,8 +80,13 @@ void Community::reset() { // used for r-zero calculations, to reset pop after a
 
     // reset locations
     for (unsigned int i = 0; i < _location.size(); i++ ) _location[i]->clearInfectedMosquitoes();
+    for (ReactiveResponse &r: _reactiveResponses) r = ReactiveResponse();
 
     for (auto &e: _isHot) e.clear();
+    for (auto &e: _vaccineDoseCalendar) e.clear();
+    _catchupVaccinationQueue.clear();
+    for (auto &e: _vectorControlStartDates) e.clear();
+    _vectorControlLocations.clear();
 
     // clear community queues & tallies
     for (unsigned int i = 0; i < _exposedQueue.size(); i++ ) _exposedQueue[i].clear();
@@ -101,6 +122,16 @@ Community::~Community() {
     Person::reset_ID_counter();
 
     for (auto &e: _isHot) e.clear();
+    for (auto &e: _vaccineDoseCalendar) e.clear();
+    _catchupVaccinationQueue.clear();
+    for (auto &e: _vectorControlStartDates) e.clear();
+    _vectorControlLocations.clear();
+
+    if (_burdenRanking) {
+        Location::setRanking(nullptr);
+        delete _burdenRanking;
+    }
+    delete _forcing;
 
     for (unsigned int i = 0; i < _location.size(); i++ ) delete _location[i];
     _location.clear();
@@ -186,58 +217,7 @@ bool Community::loadPopulation(string populationFilename, string immunityFilenam
     _peopleByAge = _people;
     sort(_peopleByAge.begin(), _peopleByAge.end(), PerPtrComp());
 
-    if (immunityFilename.length()>0) {
-        ifstream immiss(immunityFilename.c_str());
-        if (!immiss) {
-            cerr << "ERROR: " << immunityFilename << " not found." << endl;
-            return false;
-        }
-        int part;
-        vector<int> parts;
-        istringstream line;
-        int line_no = 0;
-        while ( getline(immiss,buffer) ) {
-            line_no++;
-            line.clear();
-            line.str(buffer);
-            while (line >> part) parts.push_back(part);
-
-            // 1+ without age, 2+ with age
-            if (parts.size() == 1 + NUM_OF_SEROTYPES or parts.size() == 2 + NUM_OF_SEROTYPES) {
-                const int id = parts[0];
-                Person* person = getPersonByID(id);
-                unsigned int offset = parts.size() - NUM_OF_SEROTYPES;
-                vector<pair<int,Serotype> > infection_history;
-                for (unsigned int f=offset; f<offset+NUM_OF_SEROTYPES; f++) {
-                    Serotype s = (Serotype) (f - offset);
-                    const int infection_time = parts[f];
-                    if (infection_time == 0) {
-                        continue; // no infection for this serotype
-                    } else if (infection_time<0) {
-                        infection_history.push_back(make_pair(infection_time, s));
-                    } else {
-                        cerr << "ERROR: Found positive-valued infection time in population immunity file:\n\t";
-                        cerr << "person " << person->getID() << ", serotype " << s+1 << ", time " << infection_time << "\n\n";
-                        cerr << "Infection time should be provided as a negative integer indicated how many days\n";
-                        cerr << "before the start of simulation the infection began.";
-                        exit(-359);
-                    }
-                }
-                sort(infection_history.begin(), infection_history.end());
-                for (auto p: infection_history) person->infect(p.first + _nDay, p.second);
-            } else if (parts.size() == 0) {
-                continue; // skipping blank line, or line that doesn't start with ints
-            } else {
-                cerr << "ERROR: Unexpected number of values on one line in population immunity file.\n\t";
-                cerr << "line num, line: " << line_no << ", " << buffer << "\n\n";
-                cerr << "Expected " << 1+NUM_OF_SEROTYPES << " values (person id followed by infection time for each serotype),\n";
-                cerr << "found " << parts.size() << endl;
-                exit(-361);
-            }
-            parts.clear();
-        }
-        immiss.close();
-    }
+    if (immunityFilename.length()>0 and not loadImmunity(immunityFilename)) return false;
 
     // keep track of all age cohorts for aging and mortality
     _personAgeCohort.clear();
@@ -279,6 +259,63 @@ bool Community::loadPopulation(string populationFilename, string immunityFilenam
 }
 
 
+// Infection histories for people already loaded; see loadPopulation()
+bool Community::loadImmunity(string immunityFilename) {
+    ifstream immiss(immunityFilename.c_str());
+    if (!immiss) {
+        cerr << "ERROR: " << immunityFilename << " not found." << endl;
+        return false;
+    }
+    string buffer;
+    int part;
+    vector<int> parts;
+    istringstream line;
+    int line_no = 0;
+    while ( getline(immiss,buffer) ) {
+        line_no++;
+        line.clear();
+        line.str(buffer);
+        while (line >> part) parts.push_back(part);
+
+        // 1+ without age, 2+ with age
+        if (parts.size() == 1 + NUM_OF_SEROTYPES or parts.size() == 2 + NUM_OF_SEROTYPES) {
+            const int id = parts[0];
+            Person* person = getPersonByID(id);
+            unsigned int offset = parts.size() - NUM_OF_SEROTYPES;
+            vector<pair<int,Serotype> > infection_history;
+            for (unsigned int f=offset; f<offset+NUM_OF_SEROTYPES; f++) {
+                Serotype s = (Serotype) (f - offset);
+                const int infection_time = parts[f];
+                if (infection_time == 0) {
+                    continue; // no infection for this serotype
+                } else if (infection_time<0) {
+                    infection_history.push_back(make_pair(infection_time, s));
+                } else {
+                    cerr << "ERROR: Found positive-valued infection time in population immunity file:\n\t";
+                    cerr << "person " << person->getID() << ", serotype " << s+1 << ", time " << infection_time << "\n\n";
+                    cerr << "Infection time should be provided as a negative integer indicated how many days\n";
+                    cerr << "before the start of simulation the infection began.";
+                    exit(-359);
+                }
+            }
+            sort(infection_history.begin(), infection_history.end());
+            for (auto p: infection_history) person->infect(p.first + _nDay, p.second);
+        } else if (parts.size() == 0) {
+            continue; // skipping blank line, or line that doesn't start with ints
+        } else {
+            cerr << "ERROR: Unexpected number of values on one line in population immunity file.\n\t";
+            cerr << "line num, line: " << line_no << ", " << buffer << "\n\n";
+            cerr << "Expected " << 1+NUM_OF_SEROTYPES << " values (person id followed by infection time for each serotype),\n";
+            cerr << "found " << parts.size() << endl;
+            exit(-361);
+        }
+        parts.clear();
+    }
+    immiss.close();
+    return true;
+}
+
+
 bool Community::loadLocations(string locationFilename,string networkFilename) {
     ifstream iss(locationFilename.c_str());
     if (!iss) {
@@ -359,12 +396,39 @@ bool Community::loadLocations(string locationFilename,string networkFilename) {
     }
     iss.close();
 
+    _spatialIndex.build(_location, _par->geographicCoordinates);
+
     return true;
 }
 
+// Lines are "locid region"; locations not listed stay in region 0
+bool Community::loadRegions(string regionFilename) {
+    assert(_location.size() > 0); // make sure loadLocations() was already called
+    ifstream iss(regionFilename.c_str());
+    if (!iss) { cerr << "ERROR: " << regionFilename << " not found." << endl; return false; }
+
+    string buffer;
+    int locID, region;
+    istringstream line(buffer);
+    while (getline(iss, buffer)) {
+        line.clear();
+        line.str(buffer);
+        if (line >> locID >> region) {
+            if (locID < 0 or locID >= (signed) _location.size() or region < 0) {
+                cerr << "ERROR: Bad location or region ID in " << regionFilename << ": " << buffer << endl;
+                return false;
+            }
+            _location[locID]->setRegion(region);
+        }
+    }
+    return true;
+}
+
+
 bool Community::loadMosquitoes(string moslocFilename, string mosFilename) {
     if (moslocFilename == "" and mosFilename == "") return true; // nothing to do
     assert(_location.size() > 0); // make sure loadLocations() was already called
+    INSTRUMENT_IO("load mosquitoes: " + mosFilename);
 
     ifstream iss_mosloc(moslocFilename.c_str());
     if (!iss_mosloc) { cerr << "ERROR: " << moslocFilename << " not found." << endl; return false; }
@@ -422,9 +486,11 @@ bool Community::loadMosquitoes(string moslocFilename, string mosFilename) {
             if (queue == 'e') {
                 assert(idx < (signed) _exposedMosquitoQueue.size());
                 _exposedMosquitoQueue[idx].push_back(m);
+                m->setQueueKey('e', idx + _nDay);
             } else if (queue == 'i') {
                 assert(idx < (signed) _infectiousMosquitoQueue.size());
                 _infectiousMosquitoQueue[idx].push_back(m);
+                m->setQueueKey('i', idx + _nDay);
             } else {
                 cerr << "ERROR: unknown queue type: " << queue << endl;
                 return false;
@@ -478,7 +544,11 @@ bool Community::infect(int id, Serotype serotype, int day) {
     Location* loc = nullptr;
 
     bool result =  person->infect(mos, day, loc, serotype);
-    if (result) _nNumNewlyInfected[(int) serotype][_nDay]++;
+    if (result) {
+        _nNumNewlyInfected[(int) serotype][_nDay]++;
+        for (MetricsObserver* o: _observers) o->infection(person, mos, serotype, _nDay);
+        if (_chain) _chain->humanInfection(person, mos, serotype, _nDay);
+    }
     return result;
 }
 
@@ -488,42 +558,81 @@ void Community::vaccinate(CatchupVaccinationEvent cve) {
     // so the probability of an individual being vaccinated becomes 1 - (1 - ve.coverage)^n, where n is the number
     // of times an age class is specified, either explicitly or implicitly by using a negative value for age
 
-    // Valid coverage and age?
+    // Valid coverage, age, and rollout?
     assert(cve.coverage >= 0.0 and cve.coverage <= 1.0);
     assert(cve.age <= (signed) _personAgeCohort.size());
-
-    for (Person* p: _personAgeCohort[cve.age]) {
+    assert(cve.rolloutDuration > 0);
+    _requireTickFeature(VACCINATION);
+
+    // Choosing each person independently w/ prob = coverage is equivalent to drawing the number chosen binomially
+    // and then choosing that many people uniformly, which only costs draws for the people actually chosen.  Whether
+    // a chosen person can be vaccinated (not yet vaccinated, sero-eligible) is checked when the campaign reaches them.
+    const vector<Person*>& cohort = _personAgeCohort[cve.age];
+    const int num_chosen = gsl_ran_binomial(RNG, cve.coverage, cohort.size());
+    vector<int> chosen = dengue::util::sample_indices(RNG, cohort.size(), num_chosen);
+    if (cve.rolloutDuration > 1) gsl_ran_shuffle(RNG, chosen.data(), chosen.size(), sizeof(int)); // order people are reached
+
+    for (int i = 0; i < num_chosen; ++i) {
+        Person* p = cohort[chosen[i]];
         assert(p != NULL);
-        if (!p->isVaccinated()
-            and cve.coverage > gsl_rng_uniform(RNG)
-            and p->isSeroEligible(_par->vaccineSeroConstraint, _par->seroTestFalsePos, _par->seroTestFalseNeg)
-           ) {
-            p->vaccinate(cve.simDay);
-            if (_par->vaccineBoosting or p->getNumVaccinations() < _par->numVaccineDoses) _revaccinate_set.insert(p);
+        const int day = cve.simDay + (int) (((long) i * cve.rolloutDuration) / num_chosen); // spread evenly over rollout
+        if (day == cve.simDay) {
+            _catchupVaccinate(p, day);
+        } else {
+            _catchupVaccinationQueue[day].push_back(p);
         }
     }
 }
 
 
+void Community::_catchupVaccinate(Person* p, int day) {
+    if (not p->isVaccinated()
+        and p->isSeroEligible(_par->vaccineSeroConstraint, _par->seroTestFalsePos, _par->seroTestFalseNeg)
+       ) {
+        p->vaccinate(day);
+        _scheduleNextVaccineDose(p, day);
+    }
+}
+
+
+// Returns the day p is due for a further dose or booster, or -1 if none is due
+int Community::_nextVaccineDoseDay(const Person* p) const {
+    if (not p->isVaccinated()) return -1;
+    const int last_dose = p->getVaccinationHistory().back();
+    if (p->getNumVaccinations() < _par->numVaccineDoses) {
+        return last_dose + _par->vaccineDoseInterval;             // multi-dose vaccination
+    } else if (_par->vaccineBoosting) {
+        return last_dose + _par->vaccineBoostingInterval;         // booster dose
+    }
+    return -1;                                                    // we're done
+}
+
+
+void Community::_scheduleNextVaccineDose(Person* p, int today) {
+    const int due = _nextVaccineDoseDay(p);
+    if (due < 0) return;
+    const int dose_day = std::max(due, today);                    // overdue doses (e.g. copied from a donor) are given ASAP
+    if (dose_day < (signed) _vaccineDoseCalendar.size()) _vaccineDoseCalendar[dose_day].push_back(p);
+}
+
+
 void Community::updateVaccination() {
-    for (Person* p: _revaccinate_set) {
-        if (not p->isVaccinated()) {
-            // may be in set unnecessarily because of vaccination before last birthday
-            _revaccinate_set.erase(p);
-            continue;
-        }
-        const int timeSinceLastVaccination = p->daysSinceVaccination(_nDay);
-        // TODO: Since updateVaccination only gets called on birthdays, the following only has an effect
-        // when the intervals are a multiple of years
-        if (p->getNumVaccinations() < _par->numVaccineDoses and timeSinceLastVaccination >= _par->vaccineDoseInterval) {
-            // multi-dose vaccination
-            p->vaccinate(_nDay);
-            if (p->getNumVaccinations() == _par->numVaccineDoses) _revaccinate_set.erase(p); // we're done
-        } else if (_par->vaccineBoosting and timeSinceLastVaccination >= _par->vaccineBoostingInterval) {
-            // booster dose
-            p->vaccinate(_nDay);
-        }
+    if (_catchupVaccinationQueue.count(_nDay) > 0) {                  // catch-up campaigns still rolling out
+        for (Person* p: _catchupVaccinationQueue[_nDay]) _catchupVaccinate(p, _nDay);
+        _catchupVaccinationQueue.erase(_nDay);
+    }
+
+    if (_nDay >= (signed) _vaccineDoseCalendar.size()) return;
+    vector<Person*>& due_today = _vaccineDoseCalendar[_nDay];
+    // Entries are not removed when a person's vaccination history changes (immunity swaps, resets), so each one
+    // is validated against the person's current history; stale and duplicate entries are simply skipped.
+    for (Person* p: due_today) {
+        const int due = _nextVaccineDoseDay(p);
+        if (due < 0 or due > _nDay) continue;
+        p->vaccinate(_nDay);
+        _scheduleNextVaccineDose(p, _nDay + 1);                   // never appends to due_today
     }
+    vector<Person*>().swap(due_today);                            // release memory; this day won't come again
 }
 
 
@@ -535,15 +644,22 @@ void Community::targetVaccination(Person* p) {
         and p->isSeroEligible(_par->vaccineSeroConstraint, _par->seroTestFalsePos, _par->seroTestFalseNeg)
        ) {
         // standard vaccination of target age; vaccinate w/ probability = coverage
-        if (gsl_rng_uniform(RNG) < _par->vaccineTargetCoverage) p->vaccinate(_nDay);
-        if (_par->vaccineBoosting or _par->numVaccineDoses > 1) _revaccinate_set.insert(p);
+        if (gsl_rng_uniform(RNG) < _par->vaccineTargetCoverage) {
+            p->vaccinate(_nDay);
+            _scheduleNextVaccineDose(p, _nDay);
+        }
     }
 }
 
 
 // returns number of days mosquito has left to live
-void Community::attemptToAddMosquito(Location* p, Serotype serotype, int nInfectedByID, double prob_infecting_bite) {
-    int eip = (int) (getEIP() + 0.5);
+Mosquito* Community::attemptToAddMosquito(Location* p, Serotype serotype, int nInfectedByID, double prob_infecting_bite) {
+    return _addMosquito(p, serotype, nInfectedByID, prob_infecting_bite, getEIP(p));
+}
+
+
+Mosquito* Community::_addMosquito(Location* p, Serotype serotype, int nInfectedByID, double prob_infecting_bite, double expected_eip) {
+    int eip = (int) (expected_eip + 0.5);
 
     // It doesn't make sense to have an EIP that is greater than the mosquitoes lifespan
     // Truncating also makes vector sizing more straightforward
@@ -554,18 +670,21 @@ void Community::attemptToAddMosquito(Location* p, Serotype serotype, int nInfect
     if (daysinfectious<=0) {
         // dies before infectious
         delete m;
+        m = nullptr;
     } else {
         if (eip == 0) {
             // infectious immediately -- unlikely, but supported
             // we don't push onto index 0, because we're at the end of the day already;
             // this mosquito would be destroyed before being allowed to transmit
             _infectiousMosquitoQueue[daysinfectious].push_back(m);
+            m->setQueueKey('i', daysinfectious + _nDay);
         } else {
             // more typically, add mosquito to latency queue
             _exposedMosquitoQueue[eip].push_back(m);
+            m->setQueueKey('e', eip + _nDay);
         }
     }
-    return;
+    return m;
 }
 
 
@@ -580,6 +699,97 @@ void Community::mosquitoFilter(vector<Mosquito*>& mosquitoes, const double survi
 }
 
 
+// Infected mosquitoes survive with the probability for the region they are in
+void Community::regionalMosquitoFilter(vector<Mosquito*>& mosquitoes, const vector<double>& survival_prob) {
+    unsigned int survivors = 0;
+    for (Mosquito* m: mosquitoes) {
+        const double p = survival_prob[m->getLocation()->getRegion()];
+        if (p >= 1.0 or gsl_rng_uniform(RNG) < p) {
+            mosquitoes[survivors++] = m;
+        } else {
+            delete m;
+        }
+    }
+    mosquitoes.resize(survivors);
+}
+
+
+void Community::setForcing(Forcing* forcing) {
+    for (const Location* loc: _location) {
+        if (loc->getRegion() >= forcing->numRegions()) {
+            cerr << "ERROR: Location " << loc->getID() << " is in region " << loc->getRegion() << ", but the forcing file has "
+                 << forcing->numRegions() << " regions" << endl;
+            exit(-1);
+        }
+    }
+    delete _forcing;
+    _forcing = forcing;
+    _regionCapacity.clear();
+    _regionEIP.clear();
+    _regionEIPemu.clear();
+}
+
+
+// Today's regional EIPs and capacity multipliers.  Where capacity has fallen since yesterday, infected mosquitoes die
+// off in proportion, as with applyMosquitoMultiplier(); the community-wide values are the averages over regions.
+void Community::_applyForcing() {
+    const int num_regions = _forcing->numRegions();
+    if (_forcing->has(Forcing::CAPACITY)) {
+        vector<double> survival_prob(num_regions, 1.0);
+        bool die_off = false;
+        double sum = 0.0;
+        for (int r = 0; r < num_regions; ++r) {
+            const double current = _forcing->capacity(_nDay, r);
+            if (_regionCapacity.size() and current < _regionCapacity[r]) {
+                survival_prob[r] = current/_regionCapacity[r];
+                die_off = true;
+            }
+            sum += current;
+        }
+        if (die_off) {
+            for (unsigned int day = 0; day < _exposedMosquitoQueue.size(); ++day) regionalMosquitoFilter(_exposedMosquitoQueue[day], survival_prob);
+            for (unsigned int day = 0; day < _infectiousMosquitoQueue.size(); ++day) regionalMosquitoFilter(_infectiousMosquitoQueue[day], survival_prob);
+        }
+        _regionCapacity.resize(num_regions);
+        for (int r = 0; r < num_regions; ++r) _regionCapacity[r] = _forcing->capacity(_nDay, r);
+        setMosquitoMultiplier(sum/num_regions);
+    }
+    if (_forcing->has(Forcing::EIP)) {
+        _regionEIP.resize(num_regions);
+        _regionEIPemu.resize(num_regions);
+        double sum = 0.0;
+        for (int r = 0; r < num_regions; ++r) {
+            _regionEIP[r] = _forcing->eip(_nDay, r);
+            _regionEIPemu[r] = exp(log(_regionEIP[r]) - (_EIP_sigma*_EIP_sigma)/2.0);
+            sum += _regionEIP[r];
+        }
+        setExpectedExtrinsicIncubation(sum/num_regions);
+    }
+}
+
+
+double Community::getMosquitoMultiplier(const Location* loc) const {
+    return _regionCapacity.size() ? _regionCapacity[loc->getRegion()] : _fMosquitoCapacityMultiplier;
+}
+
+
+double Community::getEIP(const Location* loc) const {
+    if (_regionEIP.empty()) return getEIP();
+    const int r = loc->getRegion();
+    return _par->simpleEIP ? _regionEIP[r] : _regionEIPemu[r] * exp(gsl_ran_gaussian(RNG, _EIP_sigma));
+}
+
+
+// getEIP(loc), for the EIP model of F
+template<class F> double Community::_drawEIP(const Location* loc) const {
+    if (_regionEIP.size()) {
+        const int r = loc->getRegion();
+        return F::sampledEIP ? _regionEIPemu[r] * exp(gsl_ran_gaussian(RNG, _EIP_sigma)) : _regionEIP[r];
+    }
+    return F::sampledEIP ? _EIP_emu * exp(gsl_ran_gaussian(RNG, _EIP_sigma)) : _expectedEIP;
+}
+
+
 void Community::applyMosquitoMultiplier(double current) {
     const double prev = getMosquitoMultiplier();
     setMosquitoMultiplier(current);
@@ -591,35 +801,105 @@ void Community::applyMosquitoMultiplier(double current) {
 }
 
 
-void Community::applyVectorControl() {
-    for (Location* loc: _location) loc->updateVectorControlQueue(_nDay); // make sure proper VC is active for tomorrow -- must be at end
+void Community::scheduleVectorControl(Location* loc, const double efficacy, const double daily_mortality, const int start, const int duration) {
+    loc->scheduleVectorControlEvent(efficacy, daily_mortality, start, duration);
+    _requireTickFeature(VECTOR_CONTROL);
+    if (start <= _nDay) {
+        _vectorControlLocations.insert(loc);                          // already started
+    } else if (start < (signed) _vectorControlStartDates.size()) {
+        _vectorControlStartDates[start].insert(loc);
+    }
+}
 
-    vector<Mosquito*> swap;
-    for (unsigned int day = 0; day < _exposedMosquitoQueue.size(); ++day) {
-        for (Mosquito* m: _exposedMosquitoQueue[day]) {
-            const float vc_rho = m->getLocation()->getCurrentVectorControlDailyMortality(_nDay);
-            if (vc_rho > 0 and gsl_rng_uniform(RNG) < vc_rho) {
-                delete m;
-            } else {
-                swap.push_back(m);
-            }
+
+void Community::scheduleTargetedVectorControl(const VectorControlEvent& vce, const double daily_mortality) {
+    _requireTickFeature(VECTOR_CONTROL);
+    if (not _burdenRanking) {
+        _burdenRanking = new LocationRanking(_location);
+        Location::setRanking(_burdenRanking);
+    }
+    int num_of_type = 0;
+    for (Location* loc: _location) num_of_type += loc->getType() == vce.locationType;
+    const int num_to_target = (int) (vce.coverage * num_of_type + 0.5);
+    _targetedVectorControl.push_back({vce, daily_mortality, num_to_target, 0, vector<bool>(_location.size(), false)});
+}
+
+
+// Each day of a MAX_MOSQUITOES_STRATEGY campaign, treat the not-yet-treated locations of the target type with the
+// highest mosquito burden, such that the campaign reaches its coverage evenly over its duration
+void Community::_applyTargetedVectorControl() {
+    // rank by the multipliers mosquito populations are sized with, i.e. regional ones with a capacity forcing table
+    const vector<double> multiplier = _regionCapacity.size() ? _regionCapacity
+                                      : vector<double>(_burdenRanking->getNumRegions(), getMosquitoMultiplier());
+    for (TargetedVectorControlCampaign& campaign: _targetedVectorControl) {
+        const VectorControlEvent& vce = campaign.vce;
+        const int campaign_day = _nDay - vce.campaignStart;
+        if (campaign_day < 0 or campaign_day >= vce.campaignDuration) continue;
+
+        const int num_by_today = (int) (((long) campaign.num_to_target * (campaign_day + 1)) / vce.campaignDuration);
+        const vector<bool>& treated = campaign.treated;
+        auto untreated = [&treated](const Location* loc) { return not treated[loc->getID()]; };
+        for (Location* loc: _burdenRanking->top(vce.locationType, num_by_today - campaign.num_targeted, multiplier, untreated)) {
+            campaign.treated[loc->getID()] = true;
+            ++campaign.num_targeted;
+            scheduleVectorControl(loc, vce.efficacy, campaign.daily_mortality, _nDay, vce.efficacyDuration);
         }
-        _exposedMosquitoQueue[day] = swap;
-        swap.clear();
     }
+}
 
-    for (unsigned int day = 0; day < _infectiousMosquitoQueue.size(); ++day) {
-        for (Mosquito* m: _infectiousMosquitoQueue[day]) {
-            const float vc_rho = m->getLocation()->getCurrentVectorControlDailyMortality(_nDay);
-            if (vc_rho > 0 and gsl_rng_uniform(RNG) < vc_rho) {
-                delete m;
-            } else {
-                swap.push_back(m);
-            }
+
+void Community::applyVectorControl() {
+    if (_targetedVectorControl.size() > 0) _applyTargetedVectorControl();
+
+    // Only locations with treatment in effect are visited.  Locations join the active set on the start date of a
+    // treatment, and leave it when no treatment is in effect; a later treatment will bring them back on its start date.
+    if (_nDay < (signed) _vectorControlStartDates.size()) {
+        _vectorControlLocations.insert(_vectorControlStartDates[_nDay].begin(), _vectorControlStartDates[_nDay].end());
+        set<Location*, LocPtrComp>().swap(_vectorControlStartDates[_nDay]);
+    }
+
+    vector<Mosquito*> killed;
+    for (auto itr = _vectorControlLocations.begin(); itr != _vectorControlLocations.end(); ) {
+        Location* loc = *itr;
+        loc->updateVectorControlQueue(_nDay);                         // make sure proper VC is active
+        if (not loc->vectorControlActive(_nDay)) {
+            itr = _vectorControlLocations.erase(itr);
+            continue;
         }
-        _infectiousMosquitoQueue[day] = swap;
-        swap.clear();
+        const float vc_rho = loc->getCurrentVectorControlDailyMortality(_nDay);
+        for (Mosquito* m: loc->getInfectedMosquitoes()) {
+            if (vc_rho > 0 and gsl_rng_uniform(RNG) < vc_rho) killed.push_back(m);
+        }
+        ++itr;
     }
+    if (killed.size() == 0) return;
+
+    // Remove the dead from the mosquito queues, only rebuilding the buckets they were in
+    vector<bool> exposed_dirty(_exposedMosquitoQueue.size(), false);
+    vector<bool> infectious_dirty(_infectiousMosquitoQueue.size(), false);
+    for (Mosquito* m: killed) {
+        m->kill();
+        const int idx = m->getQueueKey() - _nDay;
+        if (m->getQueue() == 'e') {
+            assert(idx >= 0 and idx < (signed) exposed_dirty.size());
+            exposed_dirty[idx] = true;
+        } else {
+            assert(m->getQueue() == 'i' and idx >= 0 and idx < (signed) infectious_dirty.size());
+            infectious_dirty[idx] = true;
+        }
+    }
+    auto is_dead = [](const Mosquito* m) { return m->isDead(); };
+    for (unsigned int day = 0; day < _exposedMosquitoQueue.size(); ++day) {
+        if (not exposed_dirty[day]) continue;
+        vector<Mosquito*>& bucket = _exposedMosquitoQueue[day];
+        bucket.erase(remove_if(bucket.begin(), bucket.end(), is_dead), bucket.end());
+    }
+    for (unsigned int day = 0; day < _infectiousMosquitoQueue.size(); ++day) {
+        if (not infectious_dirty[day]) continue;
+        vector<Mosquito*>& bucket = _infectiousMosquitoQueue[day];
+        bucket.erase(remove_if(bucket.begin(), bucket.end(), is_dead), bucket.end());
+    }
+    for (Mosquito* m: killed) delete m;
 }
 
 
@@ -667,9 +947,13 @@ Mosquito* Community::getExposedMosquito(int n) {
 }
 
 
-void Community::moveMosquito(Mosquito* m) {
+void Community::moveMosquito(Mosquito* m) { (this->*_phases()->moveMosquito)(m); }
+
+
+template<class F> void Community::_moveMosquito(Mosquito* m) {
     double r = gsl_rng_uniform(RNG);
     if (r<_par->fMosquitoMove) {
+        INSTRUMENT_COUNT(MOSQUITOES_MOVED, 1);
         if (r<_par->fMosquitoTeleport) {                // teleport
             int locID = gsl_rng_uniform_int(RNG,_location.size());
             m->updateLocation(_location[locID]);
@@ -682,7 +966,7 @@ void Community::moveMosquito(Mosquito* m) {
             if (degree == 0) return;                    // movement isn't possible; no neighbors exist
             int neighbor=0;                             // neighbor is an index
 
-            if (_par->mosquitoMoveModel == "weighted") {
+            if (F::weightedMovement) {
                 vector<double> weights(degree, 0);
                 double sum_weights = 0.0;
 
@@ -721,7 +1005,8 @@ void Community::moveMosquito(Mosquito* m) {
 }
 
 
-void Community::_processBirthday(Person* p) {
+template<class F> void Community::_processBirthday(Person* p) {
+    INSTRUMENT_COUNT(BIRTHDAYS_PROCESSED, 1);
     Person* donor;
     if (p->getAge() == 0) {
         //p->resetImmunity();
@@ -747,13 +1032,15 @@ void Community::_processBirthday(Person* p) {
         const int id = swap_probs[n].first;
         donor = getPersonByID(id);
     }
-    if (_par->delayBirthdayIfInfected) {
+    if (F::delayedBirthdays) {
         _swapIfNeitherInfected(p, donor);
     } else {
         if (donor) {
             p->copyImmunity(donor);
-            targetVaccination(p);
-            if (_revaccinate_set.count(donor) > 0) _revaccinate_set.insert(p);
+            if (F::vaccination) {
+                targetVaccination(p);
+                _scheduleNextVaccineDose(p, _nDay);               // p may have inherited the donor's vaccination history
+            }
         } else {
             p->resetImmunity();
         }
@@ -779,7 +1066,7 @@ void Community::_swapIfNeitherInfected(Person* p, Person* donor) {
         if (donor) {
             p->copyImmunity(donor);
             targetVaccination(p);
-            if (_revaccinate_set.count(donor) > 0) _revaccinate_set.insert(p);
+            _scheduleNextVaccineDose(p, _nDay);                   // p may have inherited the donor's vaccination history
         } else {
             p->resetImmunity();
         }
@@ -803,7 +1090,10 @@ void Community::_processDelayedBirthdays() {
 
 // 1.) Process delayed birthdays every day -- need to handle runs where normal birthdays are handled with interval > 1
 // 2.) Test delayed birthdays with having birthdays once per year on Julian day 100
-void Community::swapImmuneStates() {
+void Community::swapImmuneStates() { (this->*_phases()->swapImmuneStates)(); }
+
+
+template<class F> void Community::_swapImmuneStates() {
     const int julian = _nDay % 365;
     const int bday_ivl = _par->birthdayInterval;
     // For people of age x, copy immune status from people of age x-1
@@ -814,24 +1104,29 @@ void Community::swapImmuneStates() {
         for (int pidx = minval; pidx <= maxval; ++pidx) {
             Person* p = _peopleByAge[pidx];
             assert(p!=NULL);
-            _processBirthday(p);
+            _processBirthday<F>(p);
         }
     }
     return;
 }
 
 
-void Community::updateDiseaseStatus() {
+void Community::updateDiseaseStatus() { (this->*_phases()->updateDiseaseStatus)(); }
+
+
+template<class F> void Community::_updateDiseaseStatus() {
     for (Person* p: _people) {
         if (p->getNumNaturalInfections() == 0) continue;
         if (p->getSymptomTime()==_nDay) {                              // started showing symptoms today
             _nNumNewlySymptomatic[(int) p->getSerotype()][_nDay]++;
-            if (p->isVaccinated()) {
+            if (F::vaccination and p->isVaccinated()) {
                 _nNumVaccinatedCases[(int) p->getSerotype()][_nDay]++;
             }
             if (p->hasSevereDisease(_nDay)) {                          // symptoms will be severe at onset
                 _nNumSevereCases[(int) p->getSerotype()][_nDay]++;     // if they're going to be severe
             }
+            for (MetricsObserver* o: _observers) o->symptomOnset(p, _nDay);
+            if (_reactiveResponses.size() > 0) _reportCase(p);         // may trigger a reactive response
         }
         if (p->getWithdrawnTime()==_nDay) {                            // started withdrawing
             p->getLocation(HOME_MORNING)->addPerson(p,WORK_DAY);       // stays at home at mid-day
@@ -846,17 +1141,88 @@ void Community::updateDiseaseStatus() {
 }
 
 
+// Symptomatic case is reported w/ prob = reportedFraction; reported cases trigger the reactive interventions that are
+// underway, to start after each intervention's delay
+void Community::_reportCase(const Person* p) {
+    const InfectionOutcome outcome = p->hasSevereDisease(_nDay) ? SEVERE : MILD;
+    if (gsl_rng_uniform(RNG) >= _par->reportedFraction[(int) outcome]) return;
+    Location* home = p->getHomeLoc();
+    for (unsigned int i = 0; i < _reactiveResponses.size(); ++i) {
+        const ReactiveIntervention& ri = _par->reactiveInterventions[i];
+        if (_nDay < ri.startDate or _nDay >= ri.endDate) continue;
+        _reactiveResponses[i].triggered[_nDay + ri.delay].push_back(home);
+    }
+}
+
+
+// Locations near triggering cases are queued once (or, for vector control, again after treatment wears off), and
+// then responded to in order, subject to each intervention's daily capacity.  A location waiting in the backlog
+// isn't queued again.  Work is proportional to the number of locations affected.
+void Community::_applyReactiveInterventions() {
+    for (unsigned int i = 0; i < _reactiveResponses.size(); ++i) {
+        const ReactiveIntervention& ri = _par->reactiveInterventions[i];
+        ReactiveResponse& response = _reactiveResponses[i];
+        if (response.lastServed.size() != _location.size()) {
+            response.lastServed.assign(_location.size(), -1);
+            response.pending.assign(_location.size(), false);
+        }
+
+        while (response.triggered.size() > 0 and response.triggered.begin()->first <= _nDay) {
+            for (Location* home: response.triggered.begin()->second) {
+                _spatialIndex.forEachWithinRadius(home->getX(), home->getY(), ri.radius, [&](Location* loc) {
+                    if (response.pending[loc->getID()]) return;
+                    const int last = response.lastServed[loc->getID()];
+                    const bool requeue = ri.type == REACTIVE_VECTOR_CONTROL and _nDay - last >= ri.efficacyDuration;
+                    if (last < 0 or requeue) {
+                        response.pending[loc->getID()] = true;
+                        response.backlog.push_back(loc);
+                    }
+                });
+            }
+            response.triggered.erase(response.triggered.begin());
+        }
+
+        const double rho = ri.type == REACTIVE_VECTOR_CONTROL ? _par->calculate_daily_vector_control_mortality(ri.efficacy) : 0.0;
+        for (int n = 0; response.backlog.size() > 0 and (ri.dailyCapacity < 0 or n < ri.dailyCapacity); ++n) {
+            Location* loc = response.backlog.front();
+            response.backlog.pop_front();
+            response.pending[loc->getID()] = false;
+            response.lastServed[loc->getID()] = _nDay;
+            if (ri.type == REACTIVE_VECTOR_CONTROL) {
+                if (gsl_rng_uniform(RNG) < ri.coverage) scheduleVectorControl(loc, ri.efficacy, rho, _nDay, ri.efficacyDuration);
+            } else {
+                for (int r = 0; r < loc->getNumPerson(HOME_NIGHT); ++r) {
+                    Person* p = loc->getPerson(r, HOME_NIGHT);
+                    if (not p->isVaccinated()
+                        and p->getAge() >= ri.minAge and p->getAge() <= ri.maxAge
+                        and gsl_rng_uniform(RNG) < ri.coverage
+                        and p->isSeroEligible(_par->vaccineSeroConstraint, _par->seroTestFalsePos, _par->seroTestFalseNeg)
+                       ) {
+                        p->vaccinate(_nDay);
+                        _scheduleNextVaccineDose(p, _nDay);
+                    }
+                }
+            }
+        }
+    }
+}
+
+
 void Community::flagInfectedLocation(Location* _pLoc, int day) {
     if (day < _par->nRunLength) _isHot[day].insert(_pLoc);
 }
 
 
-void Community::mosquitoToHumanTransmission() {
+void Community::mosquitoToHumanTransmission() { (this->*_phases()->mosquitoToHumanTransmission)(); }
+
+
+template<class F> void Community::_mosquitoToHumanTransmission() {
     for(unsigned int i=0; i<_infectiousMosquitoQueue.size(); i++) {
         for(unsigned int j=0; j<_infectiousMosquitoQueue[i].size(); j++) {
             Mosquito* m = _infectiousMosquitoQueue[i][j];
             Location* pLoc = m->getLocation();
             if (gsl_rng_uniform(RNG)<_par->betaMP) {                      // infectious mosquito bites
+                INSTRUMENT_COUNT(BITES, 1);
 
                 // take sum of people in the location, weighting by time of day
                 double exposuretime[(int) NUM_OF_TIME_PERIODS];
@@ -880,7 +1246,9 @@ void Community::mosquitoToHumanTransmission() {
                     Serotype serotype = m->getSerotype();
                     if (p->infect(m, _nDay, pLoc, serotype)) {
                         _nNumNewlyInfected[(int) serotype][_nDay]++;
-                        if (_bNoSecondaryTransmission) {
+                        for (MetricsObserver* o: _observers) o->infection(p, m, serotype, _nDay);
+                        if (_chain) _chain->humanInfection(p, m, serotype, _nDay);
+                        if (F::noSecondaryTransmission) {
                             p->kill();                       // kill secondary cases so they do not transmit
                         }
                         else {
@@ -897,40 +1265,65 @@ void Community::mosquitoToHumanTransmission() {
 }
 
 
-void Community::humanToMosquitoTransmission() {
+void Community::humanToMosquitoTransmission() { (this->*_phases()->humanToMosquitoTransmission)(); }
+
+
+template<class F> void Community::_humanToMosquitoTransmission() {
+    INSTRUMENT_COUNT(HOT_LOCATIONS, _isHot[_nDay].size());
+    const double vaceffect = F::vaccination ? 1.0 - _par->fVEI : 1.0;   // relative infectiousness of vaccinees
+    const OccupantStates& states = Person::getOccupantStates();
     for (Location* loc: _isHot[_nDay]) {
         double sumviremic = 0.0;
         double sumnonviremic = 0.0;
-        vector<double> sumserotype(NUM_OF_SEROTYPES,0.0);                                    // serotype fractions at location
+        double sumserotype[NUM_OF_SEROTYPES] = {0.0};                                        // serotype fractions at location
+        vector< vector<Person*> > sources(_chain ? NUM_OF_SEROTYPES : 0);                    // viremic people, by serotype, if recording
 
-        // calculate fraction of people who are viremic
+        // calculate fraction of people who are viremic; everyone present at a time of day is bitten equally, so this
+        // only needs counts, by serotype, of viremic people and of viremic vaccinees.  Weighting counts rounds
+        // differently than adding up people one at a time did, so the sums (and, rarely, a draw that falls within
+        // rounding of a threshold) can differ in the last bit from earlier versions.
         for (int timeofday=0; timeofday<(int) NUM_OF_TIME_PERIODS; timeofday++) {
-            for (int i=loc->getNumPerson((TimePeriod) timeofday)-1; i>=0; i--) {
-                Person* p = loc->getPerson(i, (TimePeriod) timeofday);
-                if (p->isViremic(_nDay)) {
-                    double vaceffect = (p->isVaccinated()?(1.0-_par->fVEI):1.0);
-                    int serotype = (int) p->getSerotype();
-                    if (vaceffect==1.0) {
-                        sumviremic += DAILY_BITING_PDF[timeofday];
-                        sumserotype[serotype] += DAILY_BITING_PDF[timeofday];
-                    } else {
-                        sumviremic += DAILY_BITING_PDF[timeofday]*vaceffect;
-                        sumserotype[serotype] += DAILY_BITING_PDF[timeofday]*vaceffect;
-                        // a vaccinated person is treated like a fraction of an infectious person and a fraction of a non-infectious person
-                        sumnonviremic += DAILY_BITING_PDF[timeofday]*(1.0-vaceffect);
+            const int n = loc->getNumPerson((TimePeriod) timeofday);
+            const int32_t* ids = loc->getPersonIDs((TimePeriod) timeofday);
+            int viremic[NUM_OF_SEROTYPES] = {0};
+            int vaccinated[NUM_OF_SEROTYPES] = {0};
+            const int num_viremic = count_viremic(ids, n, _nDay, states, viremic, vaccinated);
+            if (num_viremic == 0) {
+                sumnonviremic += DAILY_BITING_PDF[timeofday] * n;
+                continue;
+            }
+            int num_vaccinated = 0;
+            for (int s=0; s<NUM_OF_SEROTYPES; s++) {
+                num_vaccinated += F::vaccination ? vaccinated[s] : 0;
+                sumserotype[s] += DAILY_BITING_PDF[timeofday] * (F::vaccination ? (viremic[s] - vaccinated[s]) + vaccinated[s]*vaceffect : viremic[s]);
+            }
+            // a vaccinated person is treated like a fraction of an infectious person and a fraction of a non-infectious person
+            sumviremic += DAILY_BITING_PDF[timeofday] * ((num_viremic - num_vaccinated) + num_vaccinated*vaceffect);
+            sumnonviremic += DAILY_BITING_PDF[timeofday] * ((n - num_viremic) + num_vaccinated*(1.0-vaceffect));
+            if (_chain) {
+                for (int i=0; i<n; i++) {
+                    if (states.infectious_from[ids[i]] <= _nDay and _nDay < states.infectious_to[ids[i]]) {
+                        sources[states.serotype[ids[i]]].push_back(loc->getPerson(i, (TimePeriod) timeofday));
                     }
-                } else {
-                    sumnonviremic += DAILY_BITING_PDF[timeofday];
                 }
             }
         }
 
         if (sumviremic>0.0) {
+            double cumulative[NUM_OF_SEROTYPES];                  // for select_serotype()
+            double running = 0.0;
             for (int i=0; i<NUM_OF_SEROTYPES; i++) {
                 sumserotype[i] /= sumviremic;
+                running += sumserotype[i];
+                cumulative[i] = running;
+            }
+            for (int i=NUM_OF_SEROTYPES-1; i>=0 and cumulative[i] < 2.0; i--) { // the last serotype present takes any rounding
+                cumulative[i] = 2.0;
+                if (sumserotype[i] > 0.0) break;
             }
             int locid = loc->getID();                   // location ID
-            int m = int(loc->getBaseMosquitoCapacity() * (1.0-loc->getCurrentVectorControlEfficacy(_nDay)) * getMosquitoMultiplier() + 0.5);  // number of mosquitoes
+            const double vc_efficacy = F::vectorControl ? loc->getCurrentVectorControlEfficacy(_nDay) : 0.0;
+            int m = int(loc->getBaseMosquitoCapacity() * (1.0-vc_efficacy) * getMosquitoMultiplier(loc) + 0.5);  // number of mosquitoes
             m -= loc->getCurrentInfectedMosquitoes(); // subtract off the number of already-infected mosquitos
             if (m<0) m=0; // more infected mosquitoes than the base capacity, presumable due to immigration
                                                                   // how many susceptible mosquitoes bite viremic hosts in this location?
@@ -941,11 +1334,11 @@ void Community::humanToMosquitoTransmission() {
                 if (sumserotype[0]==1.0) {
                     serotype = 0;
                 } else {
-                    double r = gsl_rng_uniform(RNG);
-                    for (serotype=0; serotype<NUM_OF_SEROTYPES && r>sumserotype[serotype]; serotype++)
-                        r -= sumserotype[serotype];
+                    serotype = select_serotype(cumulative, gsl_rng_uniform(RNG));
                 }
-                attemptToAddMosquito(loc, (Serotype) serotype, locid, prob_infecting_bite);
+                Mosquito* mos = _addMosquito(loc, (Serotype) serotype, locid, prob_infecting_bite, _drawEIP<F>(loc));
+                if (mos and _chain) _chain->mosquitoInfection(mos, loc, sources[serotype], _nDay);
+                INSTRUMENT_COUNT(MOSQUITOES_INFECTED, 1);
             }
         }
     }
@@ -988,6 +1381,7 @@ void Community::_advanceTimers() {
         int daysinfectious = m->getAgeDeath() - m->getAgeInfectious(); // - MOSQUITO_INCUBATION;
         assert((unsigned) daysinfectious < _infectiousMosquitoQueue.size());
         _infectiousMosquitoQueue[daysinfectious].push_back(m);
+        m->setQueueKey('i', daysinfectious + _nDay + 1);           // infectious queue has already advanced to tomorrow
     }
 
     for (unsigned int i=0; i<_exposedMosquitoQueue.size()-1; i++) {
@@ -1004,18 +1398,21 @@ void Community::_advanceTimers() {
 }
 
 
-void Community::_modelMosquitoMovement() {
+void Community::_modelMosquitoMovement() { (this->*_phases()->modelMosquitoMovement)(); }
+
+
+template<class F> void Community::_mosquitoMovement() {
     // move mosquitoes
     for(unsigned int i=0; i<_infectiousMosquitoQueue.size(); i++) {
         for(unsigned int j=0; j<_infectiousMosquitoQueue[i].size(); j++) {
             Mosquito* m = _infectiousMosquitoQueue[i][j];
-            moveMosquito(m);
+            _moveMosquito<F>(m);
         }
     }
     for(unsigned int i=0; i<_exposedMosquitoQueue.size(); i++) {
         for(unsigned int j=0; j<_exposedMosquitoQueue[i].size(); j++) {
             Mosquito* m = _exposedMosquitoQueue[i][j];
-            moveMosquito(m);
+            _moveMosquito<F>(m);
         }
     }
     return;
@@ -1046,28 +1443,42 @@ void Community::noSchoolOnWeekends(Date &date) {
 }
 */
 
-void Community::tick(Date &date) {
+void Community::tick(Date &date) { (this->*_phases()->tick)(date); }
+
+
+template<class F> void Community::_tick(Date &date) {
     _nDay = date.day();
-    //if ((_nDay+1)%365==0) { swapImmuneStates(1.0); }                     // randomize and advance immune states on
-    _processDelayedBirthdays();
+    for (MetricsObserver* o: _observers) o->dayStart(_nDay, _people);
+    if (_chain) _chain->dayStart(_nDay);
+    if (_forcing) {
+        INSTRUMENT_PHASE(SEASONALITY);
+        _applyForcing();
+    }
+    {
+        INSTRUMENT_PHASE(BIRTHDAYS);
+        //if ((_nDay+1)%365==0) { swapImmuneStates(1.0); }                     // randomize and advance immune states on
+        if (F::delayedBirthdays) _processDelayedBirthdays();
 
 //vector<int> vtallies(101,0);
 //for (Person* p: _people) if (p->isVaccinated()) ++vtallies[p->getAge()];
 //for (int val: vtallies) cerr << val << " "; cerr << endl;
-    if ((_nDay+1) % _par->birthdayInterval == 0) { swapImmuneStates(); }     // randomize and advance some immune states
-    updateVaccination();
-    if (_par->vectorControlEvents.size() > 0) applyVectorControl();   // also advances vector control status to next day
-                                                                      // last day of simulator year
-
-    updateDiseaseStatus();                                            // make people stay home or return to work
+        if ((_nDay+1) % _par->birthdayInterval == 0) { _swapImmuneStates<F>(); } // randomize and advance some immune states
+    }
+    if (F::vaccination) { INSTRUMENT_PHASE(VACCINATION); updateVaccination(); }
+    { INSTRUMENT_PHASE(DISEASE_STATUS);         _updateDiseaseStatus<F>(); }    // make people stay home or return to work; report cases
+    if (_reactiveResponses.size() > 0) {
+        INSTRUMENT_PHASE(REACTIVE_INTERVENTIONS);
+        _applyReactiveInterventions();                                // responses to reported cases, including today's
+    }
+    if (F::vectorControl) { INSTRUMENT_PHASE(VECTOR_CONTROL); applyVectorControl(); } // only visits locations with vector control in effect
 
 //    noSchoolOnWeekends(date);                                         // TODO - this isn't implemented correctly yet
 
-    mosquitoToHumanTransmission();                                    // infect people
+    { INSTRUMENT_PHASE(MOSQUITO_TO_HUMAN);      _mosquitoToHumanTransmission<F>(); } // infect people
 
-    humanToMosquitoTransmission();                                    // infect mosquitoes in each location
-    _advanceTimers();                                                 // advance H&M incubation periods and M ages
-    _modelMosquitoMovement();                                         // probabilistic movement of mosquitos
+    { INSTRUMENT_PHASE(HUMAN_TO_MOSQUITO);      _humanToMosquitoTransmission<F>(); } // infect mosquitoes in each location
+    { INSTRUMENT_PHASE(TIMERS);                 _advanceTimers(); }             // advance H&M incubation periods and M ages
+    { INSTRUMENT_PHASE(MOVEMENT);               _mosquitoMovement<F>(); }       // probabilistic movement of mosquitos
 
 //const Location* arm1_loc = _location[366282];
 //const Location* arm2_loc = _location[365682];
@@ -1136,6 +1547,61 @@ void Community::tick(Date &date) {
 }
 
 
+// Chooses the TickFeatures instantiation for a list of flags, one at a time, in TickFeatures' parameter order
+template<int NumUnchosen, bool... Chosen>
+struct Community::TickPhaseSelector {
+    static const TickPhases* select(const bool* features) {
+        return features[0] ? TickPhaseSelector<NumUnchosen-1, Chosen..., true>::select(features + 1)
+                           : TickPhaseSelector<NumUnchosen-1, Chosen..., false>::select(features + 1);
+    }
+};
+
+template<bool... Chosen>
+struct Community::TickPhaseSelector<0, Chosen...> {
+    static const TickPhases* select(const bool* /*features*/) {
+        typedef TickFeatures<Chosen...> F;
+        static const TickPhases phases = {
+            &Community::_tick<F>,
+            &Community::_swapImmuneStates<F>,
+            &Community::_updateDiseaseStatus<F>,
+            &Community::_mosquitoToHumanTransmission<F>,
+            &Community::_humanToMosquitoTransmission<F>,
+            &Community::_mosquitoMovement<F>,
+            &Community::_moveMosquito<F>
+        };
+        return &phases;
+    }
+};
+
+
+// A feature is on if anything that needs it is already scheduled, or will be scheduled by the parameters.  Scheduling
+// something later (vaccinate(), scheduleVectorControl(), ...) switches its feature on from the next tick.
+void Community::_selectTickPhases() {
+    bool vaccination = _par->catchupVaccinationEvents.size() > 0
+                       or _par->vaccineTargetStartDate < _par->nRunLength  // targetVaccination() draws even at 0 coverage
+                       or _catchupVaccinationQueue.size() > 0;
+    bool vector_control = _par->vectorControlEvents.size() > 0 or _targetedVectorControl.size() > 0 or _vectorControlLocations.size() > 0;
+    for (const ReactiveIntervention& ri: _par->reactiveInterventions) {
+        vaccination    = vaccination or ri.type == REACTIVE_VACCINATION;
+        vector_control = vector_control or ri.type == REACTIVE_VECTOR_CONTROL;
+    }
+    for (unsigned int day = 0; not vector_control and day < _vectorControlStartDates.size(); ++day) vector_control = _vectorControlStartDates[day].size() > 0;
+    for (unsigned int i = 0; not vaccination and i < _people.size(); ++i) vaccination = _people[i]->isVaccinated();
+
+    const bool features[] = {vaccination, vector_control, _par->mosquitoMoveModel == "weighted", not _par->simpleEIP,
+                             _par->delayBirthdayIfInfected, _bNoSecondaryTransmission};  // TickFeature order
+    const int num_features = sizeof(features)/sizeof(features[0]);
+    _tickFeatures = 0;
+    for (int i = 0; i < num_features; ++i) _tickFeatures |= features[i] ? 1u << i : 0u;
+    _tickPhases = TickPhaseSelector<num_features>::select(features);
+}
+
+
+void Community::_requireTickFeature(TickFeature f) {
+    if (_tickPhases and not (_tickFeatures & f)) _tickPhases = nullptr; // reselected on the next use
+}
+
+
 // getNumInfected - counts number of infected residents
 int Community::getNumInfected(int day) {
     int count=0;
@@ -1162,6 +1628,91 @@ vector<int> Community::getNumSusceptible() {
     return counts;
 }
 
+int Community::getNumLiveMosquitoes() const {
+    int n = 0;
+    for (const auto &bucket: _infectiousMosquitoQueue) n += bucket.size();
+    for (const auto &bucket: _exposedMosquitoQueue) n += bucket.size();
+    return n;
+}
+
+
+// Sizes are computed from capacities, so they include slack in vectors; each set/map element is charged a
+// red-black tree node header, but allocator overhead is otherwise ignored
+template <typename T> static size_t _vectorBytes(const vector<T>& v) { return v.capacity() * sizeof(T); }
+template <typename T> static size_t _nestedVectorBytes(const vector< vector<T> >& v) {
+    size_t bytes = _vectorBytes(v);
+    for (const auto &inner: v) bytes += _vectorBytes(inner);
+    return bytes;
+}
+static const size_t TREE_NODE_BYTES = 4 * sizeof(void*);
+
+vector< pair<string, size_t> > Community::getMemoryUsage() const {
+    size_t people = _vectorBytes(_people) + _nestedVectorBytes(_personAgeCohort) + _vectorBytes(_peopleByAge) + _nestedVectorBytes(_exposedQueue);
+    size_t infections = 0, vaccinations = 0, swap_probabilities = 0;
+    for (const Person* p: _people) {
+        people += sizeof(Person);
+        infections += _vectorBytes(p->getInfectionHistory()) + p->getNumNaturalInfections() * sizeof(Infection);
+        vaccinations += _vectorBytes(p->getVaccinationHistory());
+        swap_probabilities += _vectorBytes(p->getSwapProbabilities());
+    }
+
+    const OccupantStates& occupants = Person::getOccupantStates();   // static; sized to the highest person ID, with slack
+    const size_t occupant_states = _vectorBytes(occupants.infectious_from) + _vectorBytes(occupants.infectious_to)
+                                   + _vectorBytes(occupants.serotype) + _vectorBytes(occupants.vaccinated);
+
+    size_t locations = _vectorBytes(_location) + _spatialIndex.getMemoryUsage();
+    size_t person_lists = 0, neighbor_lists = 0;
+    size_t mosquito_queues = _nestedVectorBytes(_infectiousMosquitoQueue) + _nestedVectorBytes(_exposedMosquitoQueue);
+    size_t vector_control = 0;
+    for (const Location* loc: _location) {
+        locations += sizeof(Location);
+        person_lists += loc->getPersonListBytes();
+        neighbor_lists += loc->getNeighborListBytes();
+        mosquito_queues += loc->getInfectedMosquitoListBytes();
+        vector_control += loc->getVectorControlQueueBytes();
+    }
+
+    size_t hot_locations = _vectorBytes(_isHot);
+    for (const auto &hot: _isHot) hot_locations += hot.size() * (TREE_NODE_BYTES + sizeof(Location*));
+
+    const size_t tallies = _nestedVectorBytes(_nNumNewlyInfected) + _nestedVectorBytes(_nNumNewlySymptomatic)
+                           + _nestedVectorBytes(_nNumVaccinatedCases) + _nestedVectorBytes(_nNumSevereCases);
+
+    size_t delayed_birthdays = 0;
+    for (const auto &day: _delayedBirthdays) delayed_birthdays += TREE_NODE_BYTES + sizeof(day) + day.second.size() * (TREE_NODE_BYTES + sizeof(pair<Person*, Person*>));
+
+    size_t vaccine_schedule = _nestedVectorBytes(_vaccineDoseCalendar);
+    for (const auto &day: _catchupVaccinationQueue) vaccine_schedule += TREE_NODE_BYTES + sizeof(day) + _vectorBytes(day.second);
+
+    vector_control += _vectorBytes(_vectorControlStartDates) + _vectorControlLocations.size() * (TREE_NODE_BYTES + sizeof(Location*));
+    for (const auto &starts: _vectorControlStartDates) vector_control += starts.size() * (TREE_NODE_BYTES + sizeof(Location*));
+    for (const auto &campaign: _targetedVectorControl) vector_control += sizeof(campaign) + campaign.treated.capacity() / 8;
+    if (_burdenRanking) vector_control += _burdenRanking->getMemoryUsage();
+    for (const auto &response: _reactiveResponses) {
+        vector_control += _vectorBytes(response.lastServed) + response.pending.capacity() / 8 + response.backlog.size() * sizeof(Location*);
+        for (const auto &day: response.triggered) vector_control += TREE_NODE_BYTES + sizeof(day) + _vectorBytes(day.second);
+    }
+
+    return {
+        {"people",              people},
+        {"infections",          infections},
+        {"vaccinations",        vaccinations},
+        {"swap_probabilities",  swap_probabilities},
+        {"locations",           locations},
+        {"location_people",     person_lists},
+        {"occupant_states",     occupant_states},
+        {"neighbors",           neighbor_lists},
+        {"mosquito_queues",     mosquito_queues},
+        {"mosquitoes",          getNumLiveMosquitoes() * sizeof(Mosquito)},
+        {"hot_locations",       hot_locations},
+        {"tallies",             tallies},
+        {"delayed_birthdays",   delayed_birthdays},
+        {"vaccine_schedule",    vaccine_schedule},
+        {"vector_control",      vector_control}
+    };
+}
+
+
 //vector< vector<int> > Community::tallyInfectionsByLocType(bool tally_tirs = false) {
 //    vector <vector<int> > tally(NUM_OF_TRIAL_ARM_STATES, vector<int>(NUM_OF_LOCATION_TYPES + 1, 0));
 //
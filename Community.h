@@ -5,16 +5,22 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <deque>
 #include <set>
 #include <utility>
 #include <numeric>
 #include <cmath>
 #include <algorithm>
+#include "SpatialIndex.h"
 
 class Person;
 class Mosquito;
 class Location;
+class LocationRanking;
 class Date;
+class MetricsObserver;
+class TransmissionChain;
+class Forcing;
 
 // We use this to make sure that locations are iterated through in a well-defined order (by ID), rather than by mem address
 struct LocPtrComp { bool operator()(const Location* A, const Location* B) const { return A->getID() < B->getID(); } };
@@ -22,13 +28,28 @@ struct LocPtrComp { bool operator()(const Location* A, const Location* B) const
 // We use this to created a vector of people, sorted by decreasing age.  Used for aging/immunity swapping.
 struct PerPtrComp { bool operator()(const Person* A, const Person* B) const { return A->getAge() > B->getAge(); } };
 
+// Features that are fixed for a run (or only ever switched on), as compile-time flags.  Community::tick() and its
+// phases are instantiated for each combination, and the run's combination is chosen on the first tick, so a run
+// without, say, vaccination or vector control executes no code for them.
+template<bool Vaccination, bool VectorControl, bool WeightedMovement, bool SampledEIP, bool DelayedBirthdays, bool NoSecondaryTransmission>
+struct TickFeatures {
+    static constexpr bool vaccination             = Vaccination;  // anyone vaccinated, or any vaccination planned
+    static constexpr bool vectorControl           = VectorControl; // any vector control scheduled or planned
+    static constexpr bool weightedMovement        = WeightedMovement; // mosquitoMoveModel == "weighted"
+    static constexpr bool sampledEIP              = SampledEIP;   // not simpleEIP
+    static constexpr bool delayedBirthdays        = DelayedBirthdays; // delayBirthdayIfInfected
+    static constexpr bool noSecondaryTransmission = NoSecondaryTransmission;
+};
+
 class Community {
     public:
         Community(const Parameters* parameters);
         virtual ~Community();
         bool loadPopulation(std::string szPop,std::string szImm, std::string szSwap);
+        bool loadImmunity(std::string szImm);                          // also called by loadPopulation()
         bool loadLocations(std::string szLocs,std::string szNet);
         bool loadMosquitoes(std::string moslocFilename, std::string mosFilename);
+        bool loadRegions(std::string regionFilename);                  // forcing region of each location; see Forcing.h
         int getNumPeople() const { return _people.size(); }
         std::vector<Person*> getPeople() const { return _people; }
         int getNumInfected(int day);
@@ -37,48 +58,63 @@ class Community {
         void populate(Person **parray, int targetpop);
         Person* getPersonByID(int id);
         bool infect(int id, Serotype serotype, int day);
-        void attemptToAddMosquito(Location *p, Serotype serotype, int nInfectedByID, double prob_infecting_bite);
+        Mosquito* attemptToAddMosquito(Location *p, Serotype serotype, int nInfectedByID, double prob_infecting_bite); // null if it dies before becoming infectious
         int getDay() { return _nDay; }                                // what day is it?
         void swapImmuneStates();
         void updateDiseaseStatus();
         void mosquitoToHumanTransmission();
         void humanToMosquitoTransmission();
         void tick(Date &date);                                           // simulate one day
-        void setNoSecondaryTransmission() { _bNoSecondaryTransmission = true; }
+        void setNoSecondaryTransmission() { _bNoSecondaryTransmission = true; _requireTickFeature(NO_SECONDARY_TRANSMISSION); }
+        void parametersChanged() { _tickPhases = nullptr; }           // after changing a parameter tick() is specialized on, e.g. mosquitoMoveModel
         void setMosquitoMultiplier(double f) { _fMosquitoCapacityMultiplier = f; }  // seasonality multiplier for number of mosquitoes
         void applyMosquitoMultiplier(double f);                    // sets multiplier and kills off infectious mosquitoes as necessary
+        void scheduleVectorControl(Location* loc, const double efficacy, const double daily_mortality, const int start, const int duration);
+        void scheduleTargetedVectorControl(const VectorControlEvent& vce, const double daily_mortality); // MAX_MOSQUITOES_STRATEGY
         void applyVectorControl();
         double getMosquitoMultiplier() const { return _fMosquitoCapacityMultiplier; }
+        double getMosquitoMultiplier(const Location* loc) const;      // regional, with a capacity forcing table
+        void setForcing(Forcing* forcing);                            // takes ownership; applied from the next tick
+        const Forcing* getForcing() const { return _forcing; }
 
         void setExpectedExtrinsicIncubation(double n) { _expectedEIP = n; _EIP_emu = exp(log(_expectedEIP) - (_EIP_sigma*_EIP_sigma)/2.0); }
         double getExpectedExtrinsicIncubation() const { return _expectedEIP; }
         double getEIP() const { return (_par->simpleEIP ? _expectedEIP : _EIP_emu * exp(gsl_ran_gaussian(RNG, _EIP_sigma))); }
+        double getEIP(const Location* loc) const;                     // regional, with an EIP forcing table
 
         int getNumInfectiousMosquitoes();
         int getNumExposedMosquitoes();
-        void vaccinate(CatchupVaccinationEvent cve);
+        void vaccinate(CatchupVaccinationEvent cve);                  // bulk campaign, possibly rolled out over several days
         void targetVaccination(Person* p); // routine vaccination on target birthday
-        void updateVaccination();          // for boosting and multi-does vaccines
+        void updateVaccination();          // for boosting and multi-dose vaccines
         void setVES(double f);
         void setVESs(std::vector<double> f);
         Mosquito *getInfectiousMosquito(int n);
         Mosquito *getExposedMosquito(int n);
-        std::vector< std::vector<int> > getNumNewlyInfected() { return _nNumNewlyInfected; }
-        std::vector< std::vector<int> > getNumNewlySymptomatic() { return _nNumNewlySymptomatic; }
-        std::vector< std::vector<int> > getNumVaccinatedCases() { return _nNumVaccinatedCases; }
-        std::vector< std::vector<int> > getNumSevereCases() { return _nNumSevereCases; }
+        const std::vector< std::vector<int> >& getNumNewlyInfected() const { return _nNumNewlyInfected; }
+        const std::vector< std::vector<int> >& getNumNewlySymptomatic() const { return _nNumNewlySymptomatic; }
+        const std::vector< std::vector<int> >& getNumVaccinatedCases() const { return _nNumVaccinatedCases; }
+        const std::vector< std::vector<int> >& getNumSevereCases() const { return _nNumSevereCases; }
+        void addObserver(MetricsObserver* o) { _observers.push_back(o); } // not owned; see Metrics.h
+        void removeObserver(MetricsObserver* o) { _observers.erase(std::remove(_observers.begin(), _observers.end(), o), _observers.end()); }
+        void clearObservers() { _observers.clear(); }
+        void setTransmissionChain(TransmissionChain* c) { _chain = c; } // not owned; null to stop recording
         static void flagInfectedLocation(Location* _pLoc, int day);
 
         int ageIntervalSize(int ageMin, int ageMax) { return std::accumulate(_nPersonAgeCohortSizes+ageMin, _nPersonAgeCohortSizes+ageMax,0); }
 
         void reset();                                                 // reset the state of the community
         const std::vector<Location*> getLocations() const { return _location; }
+        const SpatialIndex& getSpatialIndex() const { return _spatialIndex; }
         const std::vector< std::vector<Mosquito*> > getInfectiousMosquitoes() const { return _infectiousMosquitoQueue; }
         const std::vector< std::vector<Mosquito*> > getExposedMosquitoes() const { return _exposedMosquitoQueue; }
         const std::vector<Person*> getAgeCohort(unsigned int age) const { assert(age<_personAgeCohort.size()); return _personAgeCohort[age]; }
 
         std::vector< std::vector<int> > tallyInfectionsByLocType(bool tally_tirs);
 
+        int getNumLiveMosquitoes() const;                             // infected mosquitoes, exposed or infectious
+        std::vector< std::pair<std::string, size_t> > getMemoryUsage() const; // estimated bytes, by subsystem
+
         //void noSchoolOnWeekends(Date &date);
 
     protected:
@@ -88,6 +124,7 @@ class Community {
         int _nPersonAgeCohortSizes[NUM_AGE_CLASSES];                  // size of each age cohort
         double *_fMortality;                                          // mortality by year, starting from 0
         std::vector<Location*> _location;                             // the array index is equal to the ID
+        SpatialIndex _spatialIndex;                                   // grid over location coordinates
         std::vector< std::vector<Person*> > _exposedQueue;            // queue of people with n days of latency left
         std::vector< std::vector<Mosquito*> > _infectiousMosquitoQueue;  // queue of infectious mosquitoes with n days
                                                                          // left to live
@@ -104,23 +141,85 @@ class Community {
         std::vector< std::vector<int> > _nNumNewlySymptomatic;
         std::vector< std::vector<int> > _nNumVaccinatedCases;
         std::vector< std::vector<int> > _nNumSevereCases;
+        std::vector<MetricsObserver*> _observers;                     // notified of infections and symptom onsets
+        TransmissionChain* _chain;                                    // records who infected whom, if not null
+        Forcing* _forcing;                                            // regional seasonality, if not null
+        std::vector<double> _regionCapacity;                          // today's capacity multiplier, by region
+        std::vector<double> _regionEIP;                               // today's expected EIP, by region
+        std::vector<double> _regionEIPemu;                            // and its e^mu
         static std::vector<std::set<Location*, LocPtrComp> > _isHot;
         static std::vector<Person*> _peopleByAge;
         static std::map<int, std::set<std::pair<Person*, Person*> > > _delayedBirthdays;
-        static std::set<Person*> _revaccinate_set;          // not automatically re-vaccinated, just checked for boosting, multiple doses
+        static std::vector<std::vector<Person*> > _vaccineDoseCalendar; // people due for a further dose or booster, indexed by day
+        static std::map<int, std::vector<Person*> > _catchupVaccinationQueue; // people a rollout campaign will reach, by day
 
-        static std::vector<std::set<Location*, LocPtrComp> > _vectorControlStartDates;
+        static std::vector<std::set<Location*, LocPtrComp> > _vectorControlStartDates; // Locations where treatment starts, by day
         static std::set<Location*, LocPtrComp> _vectorControlLocations; // Locations that currently have vector control measures in place
         bool _uniformSwap;                                            // use original swapping (==true); or parse swap file (==false)
 
+        struct TargetedVectorControlCampaign {                        // locations are chosen as the campaign progresses
+            VectorControlEvent vce;
+            double daily_mortality;
+            int num_to_target;                                        // coverage * number of locations of target type
+            int num_targeted;                                         // locations treated so far
+            std::vector<bool> treated;                                // by location ID
+        };
+        std::vector<TargetedVectorControlCampaign> _targetedVectorControl;
+        LocationRanking* _burdenRanking;                              // locations ranked by mosquito burden, if needed
+
+        struct ReactiveResponse {
+            std::map<int, std::vector<Location*> > triggered;         // homes of reported cases, by response day
+            std::deque<Location*> backlog;                            // locations awaiting a response, first come first served
+            std::vector<int> lastServed;                              // day each location (by ID) was last responded to, or -1
+            std::vector<bool> pending;                                // by location ID: in the backlog?
+        };
+        std::vector<ReactiveResponse> _reactiveResponses;             // parallel to _par->reactiveInterventions
+
         void expandExposedQueues();
         void expandMosquitoQueues();
         void moveMosquito(Mosquito *m);
         void mosquitoFilter(std::vector<Mosquito*>& mosquitoes, const double survival_prob);
+        void regionalMosquitoFilter(std::vector<Mosquito*>& mosquitoes, const std::vector<double>& survival_prob);
+        void _applyForcing();
         void _advanceTimers();
         void _modelMosquitoMovement();
-        void _processBirthday(Person* p);
         void _processDelayedBirthdays();
         void _swapIfNeitherInfected(Person* p, Person* donor);
+        void _applyTargetedVectorControl();
+        void _reportCase(const Person* p);
+        void _applyReactiveInterventions();
+        void _catchupVaccinate(Person* p, int day);
+        int _nextVaccineDoseDay(const Person* p) const;
+        void _scheduleNextVaccineDose(Person* p, int today);
+        Mosquito* _addMosquito(Location* p, Serotype serotype, int nInfectedByID, double prob_infecting_bite, double eip);
+
+        // tick() and the phases that depend on TickFeatures, instantiated for one combination of them
+        struct TickPhases {
+            void (Community::*tick)(Date&);
+            void (Community::*swapImmuneStates)();
+            void (Community::*updateDiseaseStatus)();
+            void (Community::*mosquitoToHumanTransmission)();
+            void (Community::*humanToMosquitoTransmission)();
+            void (Community::*modelMosquitoMovement)();
+            void (Community::*moveMosquito)(Mosquito*);
+        };
+        enum TickFeature { VACCINATION = 1, VECTOR_CONTROL = 2, WEIGHTED_MOVEMENT = 4, SAMPLED_EIP = 8, DELAYED_BIRTHDAYS = 16,
+                           NO_SECONDARY_TRANSMISSION = 32 };                 // in TickFeatures' parameter order
+        template<int NumUnchosen, bool... Chosen> struct TickPhaseSelector;
+        const TickPhases* _tickPhases;                                // chosen by _selectTickPhases(), on the first tick
+        unsigned int _tickFeatures;                                   // TickFeature flags of _tickPhases
+        const TickPhases* _phases() { if (not _tickPhases) _selectTickPhases(); return _tickPhases; }
+        void _selectTickPhases();
+        void _requireTickFeature(TickFeature f);                      // switches f on, if the current phases lack it
+
+        template<class F> void _tick(Date &date);
+        template<class F> void _swapImmuneStates();
+        template<class F> void _processBirthday(Person* p);
+        template<class F> void _updateDiseaseStatus();
+        template<class F> void _mosquitoToHumanTransmission();
+        template<class F> void _humanToMosquitoTransmission();
+        template<class F> void _mosquitoMovement();
+        template<class F> void _moveMosquito(Mosquito* m);
+        template<class F> double _drawEIP(const Location* loc) const;
 };
 #endif
@@ -20,6 +20,28 @@ static const std::vector<size_t> COMMON_END_DAY_OF_MONTH = {31, 59, 90, 120, 151
 static const std::vector<size_t> LEAP_DAYS_IN_MONTH = {31, 29, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
 static const std::vector<size_t> LEAP_END_DAY_OF_MONTH = {31, 60, 91, 121, 152, 182, 213, 244, 274, 305, 335, 366};
 
+// Month, day of month, and month-end flag for each day of a common or a leap year, so the per-day Date queries are
+// array lookups rather than searches through (copies of) the month tables
+struct CalendarDay {
+    unsigned char month;                                              // [1, 12]
+    unsigned char day_of_month;                                       // [1, 31]
+    bool end_of_month;
+};
+
+inline std::vector<CalendarDay> calendar_year(const std::vector<size_t>& end_day_of_month) { // indexed by julian day
+    std::vector<CalendarDay> days(end_day_of_month.back() + 1, CalendarDay{0, 0, false}); // [0] is unused
+    size_t julian_day = 1;
+    for (size_t m = 0; m < end_day_of_month.size(); ++m) {
+        for (size_t dom = 1; julian_day <= end_day_of_month[m]; ++dom, ++julian_day) {
+            days[julian_day] = CalendarDay{(unsigned char) (m + 1), (unsigned char) dom, julian_day == end_day_of_month[m]};
+        }
+    }
+    return days;
+}
+
+static const std::vector<CalendarDay> COMMON_CALENDAR = calendar_year(COMMON_END_DAY_OF_MONTH);
+static const std::vector<CalendarDay> LEAP_CALENDAR = calendar_year(LEAP_END_DAY_OF_MONTH);
+
 struct TimeSeriesAnchorPoint {
     string date;
     double value;
@@ -61,9 +83,13 @@ class Date {
     int offset()                const { return _offset; }
     inline int day()            const { return _simulation_day; }                                   // [0, ...]
     size_t julianDay()          const { return _julian_day; }                                       // [1, {365, 366}]
+    static const CalendarDay& calendarDay(size_t julian_day, size_t julian_year) {
+        const std::vector<CalendarDay>& calendar = isLeap(julian_year) ? LEAP_CALENDAR : COMMON_CALENDAR;
+        assert(julian_day >= 1 and julian_day < calendar.size());
+        return calendar[julian_day];
+    }
     static size_t dayOfMonth(size_t julian_day, size_t julian_year) {                               // [1, {29,30,31}]
-                                        const size_t jm = julianMonth(julian_day, julian_year);
-                                        return jm == 1 ? julian_day : julian_day - end_day_of_month(julian_year)[jm - 2];
+        return calendarDay(julian_day, julian_year).day_of_month;
     }
     size_t dayOfMonth()         const { return dayOfMonth(julianDay(), julianYear()); }
 
@@ -74,12 +100,7 @@ class Date {
 
     size_t month()              const { return _month_ct; }                                         // [0, ...]
     static size_t julianMonth(size_t julian_day, size_t julian_year) {                              // [1, 12]
-        vector<size_t>::const_iterator it;
-        // find first month that hasn't ended (hint: it's this month)
-        // julianDay()-1 because this isn't upper_or_equal_bound, which would be convenient
-        const vector<size_t> end_dom = end_day_of_month(julian_year);
-        it = upper_bound(end_dom.begin(), end_dom.end(), julian_day-1);
-        return it - end_dom.begin() + 1; // +1 b/c [1, 12], not [0, 11]
+        return calendarDay(julian_day, julian_year).month;
     }
 
     size_t julianMonth()     const {                                                                // [1, 12]
@@ -105,16 +126,9 @@ class Date {
 
     bool endOfPeriod(int n)  const { return (day()+1) % n == 0; }
     bool endOfWeek()         const { return (day()+1) % 7 == 0; }
-    bool endOfMonth()        const {
-        vector<size_t>::const_iterator it;
-        // find out if today corresponds to a month-end
-        const vector<size_t> end_dom = end_day_of_month();
-        it = find(end_dom.begin(), end_dom.end(), julianDay());
-        return it != end_dom.end();
-    }
-    static vector<size_t> end_day_of_month(size_t year) { return isLeap(year) ? LEAP_END_DAY_OF_MONTH : COMMON_END_DAY_OF_MONTH; }
-    //vector<size_t> end_day_of_month() const { return isLeap() ? LEAP_END_DAY_OF_MONTH : COMMON_END_DAY_OF_MONTH; }
-    vector<size_t> end_day_of_month() const { return end_day_of_month(julianYear()); }
+    bool endOfMonth()        const { return calendarDay(julianDay(), julianYear()).end_of_month; }
+    static const vector<size_t>& end_day_of_month(size_t year) { return isLeap(year) ? LEAP_END_DAY_OF_MONTH : COMMON_END_DAY_OF_MONTH; }
+    const vector<size_t>& end_day_of_month() const { return end_day_of_month(julianYear()); }
     bool startOfYear()       const { return startOfJulianYear(); }
     bool endOfYear()         const { return endOfJulianYear(); }                               // is it end of {365,366} day period
     bool startOfJulianYear() const { return julianDay() == 1; }                                // is it Jan 1
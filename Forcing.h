@@ -0,0 +1,112 @@
+// Forcing.h
+// Regional seasonal forcing: dense tables of the expected extrinsic incubation period and the mosquito capacity
+// multiplier, by day and region, read from a binary file (-forcingfile) that is memory-mapped rather than parsed.
+// Locations are assigned to regions with -regionfile (every location is in region 0 otherwise), and Community looks
+// up the day's values for a location's region by index.
+//
+// Like the -dailyeipfile and -mosquitomultipliers series, row 0 is January 1 of the first year, and the table
+// repeats if it is shorter than the run, without copying.  make_forcing builds a forcing file from text tables.
+#ifndef __FORCING_H
+#define __FORCING_H
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// The file is a ForcingHeader, then, for each field present, num_days rows of num_regions floats (native byte
+// order): EIP first, then capacity
+struct ForcingHeader {
+    char magic[8];                                                    // "DENFORCE"
+    uint32_t version;
+    uint32_t num_regions;
+    uint32_t num_days;
+    uint32_t fields;                                                  // Forcing::Fields, or'd together
+};
+
+class Forcing {
+    public:
+        enum Field { EIP = 1, CAPACITY = 2 };
+
+        Forcing(const std::string filename, int day_offset) : _filename(filename), _offset(day_offset), _eip(nullptr), _capacity(nullptr) {
+            const int fd = open(filename.c_str(), O_RDONLY);
+            struct stat st;
+            if (fd < 0 or fstat(fd, &st) != 0) _fail("could not open");
+            _size = st.st_size;
+            if (_size < sizeof(ForcingHeader)) _fail("too short");
+            _map = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+            close(fd);
+            if (_map == MAP_FAILED) _fail("could not map");
+
+            const ForcingHeader* header = (const ForcingHeader*) _map;
+            if (strncmp(header->magic, "DENFORCE", 8) != 0 or header->version != 1) _fail("not a version 1 forcing file");
+            _numRegions = header->num_regions;
+            _numDays = header->num_days;
+            _fields = header->fields;
+            if (_numRegions == 0 or _numDays == 0 or _fields == 0 or (_fields & ~(EIP | CAPACITY))) _fail("bad header");
+            const size_t table = (size_t) _numRegions * _numDays;
+            if (_size != sizeof(ForcingHeader) + table * sizeof(float) * ((_fields & EIP ? 1 : 0) + (_fields & CAPACITY ? 1 : 0))) _fail("wrong size");
+            const float* data = (const float*) (header + 1);
+            if (_fields & EIP) { _eip = data; data += table; }
+            if (_fields & CAPACITY) { _capacity = data; }
+            for (size_t i = 0; i < table; ++i) {
+                if (_eip and not (_eip[i] > 0)) _fail("EIP <= 0");
+                if (_capacity and not (_capacity[i] >= 0)) _fail("capacity multiplier < 0");
+            }
+        }
+
+        ~Forcing() { munmap(_map, _size); }
+
+        bool has(Field f) const { return _fields & f; }
+        int numRegions() const { return _numRegions; }
+        int numDays() const { return _numDays; }
+
+        // day is the simulation day
+        double eip(int day, int region) const { return _eip[_row(day) + region]; }
+        double capacity(int day, int region) const { return _capacity[_row(day) + region]; }
+
+        // tables are num_days x num_regions, row-major; either may be empty
+        static void write(const std::string filename, uint32_t num_regions, uint32_t num_days, const std::vector<float>& eip, const std::vector<float>& capacity) {
+            const uint32_t fields = (eip.size() ? EIP : 0) | (capacity.size() ? CAPACITY : 0);
+            ForcingHeader header = {{'D', 'E', 'N', 'F', 'O', 'R', 'C', 'E'}, 1, num_regions, num_days, fields};
+            FILE* fh = fopen(filename.c_str(), "wb");
+            if (not fh) {
+                std::cerr << "ERROR: Could not open forcing file for writing: " << filename << std::endl;
+                exit(-1);
+            }
+            fwrite(&header, sizeof(header), 1, fh);
+            fwrite(eip.data(), sizeof(float), eip.size(), fh);
+            fwrite(capacity.data(), sizeof(float), capacity.size(), fh);
+            if (fclose(fh) != 0) {
+                std::cerr << "ERROR: Could not write forcing file: " << filename << std::endl;
+                exit(-1);
+            }
+        }
+
+    private:
+        size_t _row(int day) const { return (size_t) ((day + _offset) % _numDays) * _numRegions; }
+
+        void _fail(const std::string what) const {
+            std::cerr << "ERROR: Forcing file " << _filename << ": " << what << std::endl;
+            exit(-1);
+        }
+
+        const std::string _filename;
+        const int _offset;                                            // simulation day 0 is this many days into row 0's year
+        size_t _size;
+        void* _map;
+        int _numRegions;
+        int _numDays;
+        uint32_t _fields;
+        const float* _eip;                                            // into _map; null if not present
+        const float* _capacity;
+};
+
+#endif
@@ -0,0 +1,96 @@
+// IncidenceRaster.h
+// Infections, cases, and infected mosquitoes on a grid of square cells in location coordinates (by default the
+// 0.00416667-degree pixels of the synthetic population), one frame per week or month, written as sparse CSV: one
+// line per cell with anything to report.  Cell c covers [c*cell_size, (c+1)*cell_size) in each direction, so
+// frames from different runs line up; x and y in the output are cell centers.
+//
+// Infections and cases (symptomatic infections) are counted on the day of infection, in the cell of the person's
+// home, as in the periodic output; infected mosquitoes are those alive at the end of the frame.  Location-to-cell
+// indices are computed once, when the raster is made, so counting an infection is an array increment.
+//
+// Frames read the locations when they end, so the final, partial frame is written by finish(), which must be
+// called while the community still exists (close_run_output() does this).
+#ifndef __INCIDENCE_RASTER_H
+#define __INCIDENCE_RASTER_H
+
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <map>
+#include <utility>
+#include <vector>
+#include "Metrics.h"
+#include "Output.h"
+
+class IncidenceRaster : public MetricsObserver {
+    public:
+        IncidenceRaster(const std::vector<Location*>& locations, double cell_size, OutputSink* sink) : // takes ownership of sink
+            _locations(locations), _cellSize(cell_size), _sink(sink), _locationCell(locations.size()), _day(0), _frameOpen(false) {
+            assert(cell_size > 0.0);
+            std::map<std::pair<int, int>, int> cells;                 // (row, col) -> index; rows, then columns, ascending
+            for (const Location* loc: locations) cells[_cellOf(loc)] = 0;
+            for (auto &c: cells) {
+                c.second = _cells.size();
+                _cells.push_back(c.first);
+            }
+            for (unsigned int i = 0; i < locations.size(); ++i) _locationCell[i] = cells[_cellOf(locations[i])];
+            _infections.assign(_cells.size(), 0);
+            _cases.assign(_cells.size(), 0);
+            _mosquitoes.assign(_cells.size(), 0);
+            _sink->write(std::string("day,col,row,x,y,infections,cases,infected_mosquitoes\n"));
+        }
+
+        ~IncidenceRaster() {                                          // never reads the locations, which may be gone
+            if (_frameOpen) std::cerr << "WARNING: incidence raster destroyed without finish(); final partial frame (day " << _day << ") not written" << std::endl;
+            delete _sink;
+        }
+
+        void finish() { if (_frameOpen) endFrame(_day); }             // writes a final, partial frame
+
+        void dayStart(int day, const std::vector<Person*>& /*people*/) { _day = day; _frameOpen = true; }
+
+        void infection(const Person* p, const Mosquito* /*mos*/, Serotype /*serotype*/, int /*day*/) {
+            const int c = _locationCell[p->getHomeLoc()->getID()];
+            ++_infections[c];
+            _cases[c] += p->getInfection()->isSymptomatic();
+        }
+
+        // Writes the frame that ends on day, and starts the next one
+        void endFrame(int day) {
+            for (unsigned int i = 0; i < _locations.size(); ++i) _mosquitoes[_locationCell[i]] += _locations[i]->getCurrentInfectedMosquitoes();
+            char line[200];
+            for (unsigned int c = 0; c < _cells.size(); ++c) {
+                if (_infections[c] == 0 and _mosquitoes[c] == 0) continue;
+                const int row = _cells[c].first, col = _cells[c].second;
+                const int n = snprintf(line, sizeof(line), "%d,%d,%d,%.8g,%.8g,%d,%d,%d\n", day, col, row, (col + 0.5)*_cellSize,
+                                       (row + 0.5)*_cellSize, _infections[c], _cases[c], _mosquitoes[c]);
+                _sink->write(line, n);
+            }
+            _infections.assign(_cells.size(), 0);
+            _cases.assign(_cells.size(), 0);
+            _mosquitoes.assign(_cells.size(), 0);
+            _frameOpen = false;
+        }
+
+        void flush() { _sink->flush(); }
+        int numCells() const { return _cells.size(); }                // cells with at least one location
+        void appendMetrics(std::vector<double>& /*metrics*/) const {}
+
+    private:
+        std::pair<int, int> _cellOf(const Location* loc) const {
+            return std::make_pair((int) floor(loc->getY() / _cellSize), (int) floor(loc->getX() / _cellSize));
+        }
+
+        const std::vector<Location*> _locations;                      // by ID
+        const double _cellSize;
+        OutputSink* _sink;
+        std::vector<int> _locationCell;                               // by location ID
+        std::vector<std::pair<int, int> > _cells;                     // (row, col)
+        std::vector<int> _infections;                                 // by cell, this frame
+        std::vector<int> _cases;
+        std::vector<int> _mosquitoes;                                 // at the end of the frame
+        int _day;                                                     // today
+        bool _frameOpen;                                              // any days since the last endFrame()?
+};
+
+#endif
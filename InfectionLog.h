@@ -0,0 +1,88 @@
+// InfectionLog.h
+// The infection line list: one fixed-size InfectionRecord per infection, in the order they happen, appended to a
+// binary file (-infectionlogfile).  The log is a MetricsObserver, so it sees each infection as Community makes it,
+// while the infecting mosquito and its origin are still known; logging one costs a 20-byte copy.  Records collect
+// in a bounded ring buffer that is drained to the output sink, oldest first, when it fills and on flush, so memory
+// use does not grow with run length.  decode_infections converts a log to CSV, optionally filtered by day and by
+// region.
+#ifndef __INFECTION_LOG_H
+#define __INFECTION_LOG_H
+
+#include <cstdint>
+#include <algorithm>
+#include <vector>
+#include "Metrics.h"
+#include "Output.h"
+#include "Mosquito.h"
+
+// The file starts with an InfectionLogHeader, followed by InfectionRecords in native byte order
+struct InfectionLogHeader {
+    char magic[8];                                                    // "DENINFEC"
+    uint32_t version;
+    uint32_t record_size;                                             // sizeof(InfectionRecord)
+    uint64_t serial;
+};
+
+struct InfectionRecord {
+    enum Flag : uint8_t { INTRODUCTION = 1, SYMPTOMATIC = 2, SEVERE = 4, VACCINATED = 8 };
+    int32_t day;
+    int32_t person_id;
+    int32_t location_id;                                              // where infected; home, for introductions
+    int32_t origin_location_id;                                       // where the mosquito was infected; -1 for introductions
+    int16_t age;
+    int8_t serotype;
+    uint8_t flags;                                                    // Flags, or'd together
+};
+static_assert(sizeof(InfectionRecord) == 20, "InfectionRecord must stay packed");
+
+class InfectionLog : public MetricsObserver {
+    public:
+        InfectionLog(OutputSink* sink, uint64_t serial, size_t capacity = 1 << 16) : // takes ownership of sink
+            _sink(sink), _ring(capacity), _head(0), _size(0), _numRecords(0) {
+            assert(capacity > 0);
+            InfectionLogHeader header = {{'D', 'E', 'N', 'I', 'N', 'F', 'E', 'C'}, 1, sizeof(InfectionRecord), serial};
+            _sink->write((const char*) &header, sizeof(header));
+        }
+
+        ~InfectionLog() { flush(); delete _sink; }
+
+        void infection(const Person* p, const Mosquito* mos, Serotype serotype, int day) {
+            if (_size == _ring.size()) _drain();
+            const Infection* infec = p->getInfection();
+            const Location* loc = infec->getInfectedLoc();
+            InfectionRecord &r = _ring[(_head + _size) % _ring.size()];
+            r.day = day;
+            r.person_id = p->getID();
+            r.location_id = loc ? loc->getID() : p->getHomeLoc()->getID();
+            r.origin_location_id = (mos and mos->getOriginLocation()) ? mos->getOriginLocation()->getID() : -1;
+            r.age = p->getAge();
+            r.serotype = (int8_t) serotype;
+            r.flags = (mos ? 0 : InfectionRecord::INTRODUCTION)
+                    | (infec->isSymptomatic() ? InfectionRecord::SYMPTOMATIC : 0)
+                    | (infec->isSevere() ? InfectionRecord::SEVERE : 0)
+                    | (p->isVaccinated() ? InfectionRecord::VACCINATED : 0);
+            ++_size;
+            ++_numRecords;
+        }
+
+        void flush() { _drain(); _sink->flush(); }
+        uint64_t numRecords() const { return _numRecords; }
+        void appendMetrics(std::vector<double>& /*metrics*/) const {}
+
+    private:
+        void _drain() {                                               // at most two contiguous writes
+            const size_t first = std::min(_size, _ring.size() - _head);
+            _sink->write((const char*) &_ring[_head], first*sizeof(InfectionRecord));
+            _sink->write((const char*) &_ring[0], (_size - first)*sizeof(InfectionRecord));
+            _head = (_head + _size) % _ring.size();
+            _size = 0;
+        }
+
+        OutputSink* _sink;
+        std::vector<InfectionRecord> _ring;
+        size_t _head;                                                 // oldest buffered record
+        size_t _size;                                                 // buffered records
+        uint64_t _numRecords;                                         // logged in total
+};
+
+#endif
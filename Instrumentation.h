@@ -0,0 +1,247 @@
+// Instrumentation.h
+// Low-overhead timing and counters for the phases of a simulated day, aggregated per simulated year, and an
+// optional timeline of the same phases (plus file loads, checkpoints, and output flushes) in Chrome trace-event
+// JSON, viewable in chrome://tracing or Perfetto.
+//
+// Only compiled in when DENGUE_INSTRUMENT is defined (e.g. make INSTRUMENT=1); otherwise the INSTRUMENT_* macros
+// expand to nothing and their arguments are never evaluated.
+#ifndef __INSTRUMENTATION_H
+#define __INSTRUMENTATION_H
+
+#ifdef DENGUE_INSTRUMENT
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+#include <gsl/gsl_rng.h>
+
+namespace dengue {
+    namespace instrument {
+        enum Phase {
+            SEASONALITY,                                              // mosquito multiplier & EIP updates
+            BIRTHDAYS,                                                // delayed birthdays & immunity swapping
+            VACCINATION,                                              // doses, boosters, catch-up rollouts
+            REACTIVE_INTERVENTIONS,
+            VECTOR_CONTROL,
+            DISEASE_STATUS,
+            MOSQUITO_TO_HUMAN,
+            HUMAN_TO_MOSQUITO,
+            TIMERS,
+            MOVEMENT,
+            REPORTING,                                                // incidence/prevalence tallies & periodic output
+            NUM_OF_PHASES
+        };
+        static const char* const PHASE_NAMES[NUM_OF_PHASES] = {"seasonality", "birthdays", "vaccination", "reactive", "vector_control",
+            "disease_status", "mosquito_to_human", "human_to_mosquito", "timers", "movement", "reporting"};
+
+        enum Counter {
+            BIRTHDAYS_PROCESSED,
+            BITES,                                                    // by infectious mosquitoes
+            HOT_LOCATIONS,                                            // locations with infectious people
+            MOSQUITOES_INFECTED,
+            MOSQUITOES_MOVED,
+            RNG_DRAWS,
+            NUM_OF_COUNTERS
+        };
+        static const char* const COUNTER_NAMES[NUM_OF_COUNTERS] = {"births", "bites", "hot_locations", "mosquitoes_infected",
+            "mosquitoes_moved", "rng_draws"};
+
+        struct Tally {
+            uint64_t ns[NUM_OF_PHASES];
+            uint64_t counts[NUM_OF_COUNTERS];
+            void clear() { for (auto &v: ns) v = 0; for (auto &v: counts) v = 0; }
+        };
+
+        inline Tally& tally() { static Tally t = Tally(); return t; }
+
+        // Timeline of sampled days and of all I/O, held in a fixed-size buffer and written out as a Chrome trace.
+        // Events past the buffer size are dropped (and counted), so tracing can be left on for long runs.
+        class Trace {
+            public:
+                enum Kind { DAY, PHASE, IO };
+
+                struct Event {                                        // 24 bytes; I/O labels are interned
+                    int64_t start;                                    // ns since the trace epoch
+                    int64_t duration;                                 // ns
+                    int32_t arg;                                      // day, phase, or label index
+                    int32_t kind;
+                };
+
+                Trace() : _interval(0), _sampling(false), _dropped(0), _epoch(std::chrono::steady_clock::now()) {}
+
+                // interval == 0 disables tracing; otherwise every interval-th simulated day is traced
+                void configure(const std::string& filename, int interval, unsigned int max_events) {
+                    _filename = filename;
+                    _interval = filename.empty() ? 0 : interval;
+                    _events.clear();
+                    _events.reserve(_interval > 0 ? max_events : 0);
+                    _dropped = 0;
+                }
+
+                bool enabled() const { return _interval > 0; }
+                bool sampling() const { return _sampling; }
+                void startDay(int day) { _sampling = enabled() and day % _interval == 0; }
+
+                int64_t now() const {
+                    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - _epoch).count();
+                }
+
+                void record(Kind kind, int32_t arg, int64_t start, int64_t end) {
+                    if (_events.size() == _events.capacity()) { ++_dropped; return; }
+                    Event e = {start, end - start, arg, kind};
+                    _events.push_back(e);
+                }
+
+                int32_t label(const std::string& l) {
+                    auto it = _labelIndex.find(l);
+                    if (it != _labelIndex.end()) return it->second;
+                    _labels.push_back(l);
+                    return _labelIndex[l] = _labels.size() - 1;
+                }
+
+                // Writes everything recorded so far to filename.<process_id>, then starts over, so each run in a
+                // process (e.g. each ABC particle) gets its own file
+                void write(const std::string& process_id) {
+                    if (not enabled()) return;
+                    const std::string filename = _filename + "." + process_id;
+                    FILE* fh = fopen(filename.c_str(), "w");
+                    if (not fh) {
+                        std::cerr << "ERROR: Could not open trace file for output: " << filename << std::endl;
+                        exit(-850);
+                    }
+                    fprintf(fh, "{\"traceEvents\":[\n");
+                    fprintf(fh, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"tid\":0,\"args\":{\"name\":\"dengue %s\"}}",
+                            _escape(process_id).c_str());
+                    for (const Event& e: _events) {
+                        fprintf(fh, ",\n{\"ph\":\"X\",\"pid\":0,\"tid\":0,\"ts\":%.3f,\"dur\":%.3f,", e.start / 1000.0, e.duration / 1000.0);
+                        switch (e.kind) {
+                            case DAY:   fprintf(fh, "\"cat\":\"day\",\"name\":\"day\",\"args\":{\"day\":%d}}", e.arg); break;
+                            case PHASE: fprintf(fh, "\"cat\":\"phase\",\"name\":\"%s\"}", PHASE_NAMES[e.arg]); break;
+                            case IO:    fprintf(fh, "\"cat\":\"io\",\"name\":\"%s\"}", _escape(_labels[e.arg]).c_str()); break;
+                        }
+                    }
+                    fprintf(fh, "\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"sampling_interval_days\":%d,\"dropped_events\":%lu}}\n",
+                            _interval, (unsigned long) _dropped);
+                    fclose(fh);
+                    _events.clear();
+                    _dropped = 0;
+                }
+
+            private:
+                std::string _filename;
+                int _interval;
+                bool _sampling;                                       // is the current day being traced?
+                uint64_t _dropped;
+                std::vector<Event> _events;
+                std::vector<std::string> _labels;
+                std::map<std::string, int32_t> _labelIndex;
+                std::chrono::steady_clock::time_point _epoch;
+
+                static std::string _escape(const std::string& s) {
+                    std::string out;
+                    for (char c: s) {
+                        if (c == '"' or c == '\\') out += '\\';
+                        if ((unsigned char) c >= 0x20) out += c;
+                    }
+                    return out;
+                }
+        };
+
+        inline Trace& trace() { static Trace t; return t; }
+
+        class PhaseTimer {
+            public:
+                PhaseTimer(Phase phase) : _phase(phase), _start(trace().now()) {}
+                ~PhaseTimer() {
+                    const int64_t end = trace().now();
+                    tally().ns[_phase] += end - _start;
+                    if (trace().sampling()) trace().record(Trace::PHASE, _phase, _start, end);
+                }
+            private:
+                Phase _phase;
+                int64_t _start;
+        };
+
+        // Spans a whole simulated day; decides whether the day is sampled
+        class DaySpan {
+            public:
+                DaySpan(int day) : _day(day) { trace().startDay(day); _start = trace().now(); }
+                ~DaySpan() { if (trace().sampling()) trace().record(Trace::DAY, _day, _start, trace().now()); }
+            private:
+                int _day;
+                int64_t _start;
+        };
+
+        // File loads, checkpoints and other rare I/O are always traced; per-day output flushes only on sampled days
+        class IoSpan {
+            public:
+                IoSpan(const std::string& label, bool every_day = false) : _active(trace().enabled() and (not every_day or trace().sampling())) {
+                    if (_active) { _label = trace().label(label); _start = trace().now(); }
+                }
+                ~IoSpan() { if (_active) trace().record(Trace::IO, _label, _start, trace().now()); }
+            private:
+                bool _active;
+                int32_t _label;
+                int64_t _start;
+        };
+
+        // Counts RNG draws by interposing on the generator's type: same state, same stream, one increment per draw
+        struct CountingRng {
+            static const gsl_rng_type*& base() { static const gsl_rng_type* b = nullptr; return b; }
+            static unsigned long int get(void* state) { ++tally().counts[RNG_DRAWS]; return base()->get(state); }
+            static double get_double(void* state) { ++tally().counts[RNG_DRAWS]; return base()->get_double(state); }
+        };
+
+        inline void count_rng_draws(const gsl_rng* rng) {
+            static gsl_rng_type counting;
+            if (rng->type == &counting) return;                       // already counting
+            CountingRng::base() = rng->type;
+            counting = *rng->type;
+            counting.get = &CountingRng::get;
+            counting.get_double = &CountingRng::get_double;
+            const_cast<gsl_rng*>(rng)->type = &counting;
+        }
+
+        // One machine-readable line, then the tallies start over
+        inline void report(std::ostream& os, const std::string& process_id, int year) {
+            Tally& t = tally();
+            os << process_id << " instrumentation year: " << year << " ns:";
+            for (int i = 0; i < NUM_OF_PHASES; ++i) os << " " << PHASE_NAMES[i] << "=" << t.ns[i];
+            os << " counts:";
+            for (int i = 0; i < NUM_OF_COUNTERS; ++i) os << " " << COUNTER_NAMES[i] << "=" << t.counts[i];
+            os << std::endl;
+            t.clear();
+        }
+    }
+}
+
+#define INSTRUMENT_CONCAT_(a, b) a##b
+#define INSTRUMENT_CONCAT(a, b) INSTRUMENT_CONCAT_(a, b)
+#define INSTRUMENT_PHASE(phase) dengue::instrument::PhaseTimer INSTRUMENT_CONCAT(_instrument_timer_, __LINE__)(dengue::instrument::phase)
+#define INSTRUMENT_COUNT(counter, n) (dengue::instrument::tally().counts[dengue::instrument::counter] += (n))
+#define INSTRUMENT_RNG(rng) dengue::instrument::count_rng_draws(rng)
+#define INSTRUMENT_REPORT(os, process_id, year) dengue::instrument::report(os, process_id, year)
+#define INSTRUMENT_DAY(day) dengue::instrument::DaySpan INSTRUMENT_CONCAT(_instrument_day_, __LINE__)(day)
+#define INSTRUMENT_IO(label) dengue::instrument::IoSpan INSTRUMENT_CONCAT(_instrument_io_, __LINE__)(label)
+#define INSTRUMENT_FLUSH(label) dengue::instrument::IoSpan INSTRUMENT_CONCAT(_instrument_io_, __LINE__)(label, true)
+#define INSTRUMENT_TRACE_CONFIGURE(filename, interval, max_events) dengue::instrument::trace().configure(filename, interval, max_events)
+#define INSTRUMENT_TRACE_WRITE(process_id) dengue::instrument::trace().write(process_id)
+
+#else
+
+#define INSTRUMENT_PHASE(phase)
+#define INSTRUMENT_COUNT(counter, n)
+#define INSTRUMENT_RNG(rng)
+#define INSTRUMENT_REPORT(os, process_id, year)
+#define INSTRUMENT_DAY(day)
+#define INSTRUMENT_IO(label)
+#define INSTRUMENT_FLUSH(label)
+#define INSTRUMENT_TRACE_CONFIGURE(filename, interval, max_events)
+#define INSTRUMENT_TRACE_WRITE(process_id)
+
+#endif
+#endif
@@ -9,19 +9,21 @@
 #include "Mosquito.h"
 #include "Person.h"
 #include "Location.h"
+#include "LocationRanking.h"
 #include "Parameters.h"
 
 using namespace dengue::standard;
 
 int Location::_nNextSerial = 0;
+LocationRanking* Location::_ranking = nullptr;
 //int Location::_nDefaultMosquitoCapacity;
 
 Location::Location()
-    : _person((int) NUM_OF_TIME_PERIODS, vector<Person*>(0) ) {
+    : _person((int) NUM_OF_TIME_PERIODS, vector<Person*>(0) ), _personID((int) NUM_OF_TIME_PERIODS) {
     _serial = _nNextSerial++;
     _ID = 0;
     _nBaseMosquitoCapacity = 0;
-    _currentInfectedMosquitoes = 0;
+    _region = 0;
     _coord = make_pair(0.0, 0.0);
     _type = NUM_OF_LOCATION_TYPES; // compileable, but not sensible value, because it must be set elsewhere
 }
@@ -29,13 +31,16 @@ Location::Location()
 
 Location::~Location() {
     _person.clear();
+    _personID.clear();
     _neighbors.clear();
+    _infectedMosquitoes.clear();
 }
 
 
 void Location::addPerson(Person* p, int t) {
     assert((unsigned) t < _person.size());
     _person[t].push_back(p);
+    _personID[t].push_back(p->getID());
 }
 
 
@@ -45,6 +50,8 @@ bool Location::removePerson(Person* p, int t) {
         if (_person[t][i] == p) {
             _person[t][i] = _person[t].back();
             _person[t].pop_back();
+            _personID[t][i] = _personID[t].back();
+            _personID[t].pop_back();
             return true;
         }
     }
@@ -52,6 +59,34 @@ bool Location::removePerson(Person* p, int t) {
 }
 
 
+void Location::addInfectedMosquito(Mosquito* m) {
+    m->setLocationSlot(_infectedMosquitoes.size());
+    _infectedMosquitoes.push_back(m);
+    if (_ranking) _ranking->infectedMosquitoCountChanged(this, _infectedMosquitoes.size() - 1);
+}
+
+
+// O(1): swap-and-pop using the slot the mosquito was given when added.  A mosquito still pointing here after
+// clearInfectedMosquitoes() is not in the list, which the slot check catches.
+bool Location::removeInfectedMosquito(Mosquito* m) {
+    const int i = m->getLocationSlot();
+    if (i < 0 or i >= (signed) _infectedMosquitoes.size() or _infectedMosquitoes[i] != m) return false;
+    _infectedMosquitoes[i] = _infectedMosquitoes.back();
+    _infectedMosquitoes[i]->setLocationSlot(i);
+    _infectedMosquitoes.pop_back();
+    m->setLocationSlot(-1);
+    if (_ranking) _ranking->infectedMosquitoCountChanged(this, _infectedMosquitoes.size() + 1);
+    return true;
+}
+
+
+void Location::clearInfectedMosquitoes() {
+    const int old_count = _infectedMosquitoes.size();
+    _infectedMosquitoes.clear();
+    if (_ranking) _ranking->infectedMosquitoCountChanged(this, old_count);
+}
+
+
 // Calling scope must verify that returned person is not nullptr
 Person* Location::findMom() {
     vector<Person*> residents = getResidents();
@@ -75,3 +110,11 @@ void Location::addNeighbor(Location* p) {
         if (_neighbors[i]==p) return;                                                   // already a neighbor
     _neighbors.push_back(p);
 }
+
+
+size_t Location::getPersonListBytes() const {
+    size_t bytes = _person.capacity() * sizeof(std::vector<Person*>);
+    for (const auto &people: _person) bytes += people.capacity() * sizeof(Person*);
+    for (const auto &ids: _personID) bytes += ids.capacity() * sizeof(int32_t);
+    return bytes;
+}
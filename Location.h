@@ -5,8 +5,12 @@
 #define __LOCATION_H
 
 #include <queue>
+#include <vector>
+#include <cstdint>
 
 class Person;
+class Mosquito;
+class LocationRanking;
 
 struct InsecticideTreatmentEvent {
     InsecticideTreatmentEvent(double eff, double m, int s, int d) : efficacy(eff), daily_mortality(m), start_day(s), end_day(s+d) {};
@@ -35,6 +39,8 @@ class Location {
         TrialArmState getTrialArm() const { return _trial_arm; }
         void setSurveilled(bool surveilled) { _surveilled = surveilled; }
         bool isSurveilled() const { return _surveilled; }
+        void setRegion(int region) { _region = region; }
+        int getRegion() const { return _region; }                     // forcing region; see Forcing.h
 
         void addPerson(Person *p, int t);
         bool removePerson(Person *p, int t);
@@ -44,7 +50,9 @@ class Location {
         void setBaseMosquitoCapacity(int capacity) { _nBaseMosquitoCapacity = capacity; }
                                                                                       // not really killing of I and S mosquitoes in the same way . . .
         int getBaseMosquitoCapacity() const { return _nBaseMosquitoCapacity; }
-        int getCurrentInfectedMosquitoes() const { return _currentInfectedMosquitoes; }
+        int getCurrentInfectedMosquitoes() const { return _infectedMosquitoes.size(); }
+        const std::vector<Mosquito*>& getInfectedMosquitoes() const { return _infectedMosquitoes; }
+        // Community::scheduleVectorControl() should normally be used, so that the community knows when treatment starts
         void scheduleVectorControlEvent(const double efficacy, const double daily_mortality, const int start, const int duration) {
             ITQ.emplace(efficacy, daily_mortality, start, duration);
         }
@@ -59,21 +67,25 @@ class Location {
         }
         double getCurrentVectorControlEfficacy(int now) const { return vectorControlActive(now) ? ITQ.top().efficacy : 0.0; }
         double getCurrentVectorControlDailyMortality(int now) const { return vectorControlActive(now) ? ITQ.top().daily_mortality : 0.0; }
-        void addInfectedMosquito() { _currentInfectedMosquitoes++; }
-        void addInfectedMosquitoes(int n) { _currentInfectedMosquitoes += n; }
-        void removeInfectedMosquito() { _currentInfectedMosquitoes--; }
-        void removeInfectedMosquitoes(int n) { _currentInfectedMosquitoes -= n; }
-        void clearInfectedMosquitoes() { _currentInfectedMosquitoes = 0; }
+        void addInfectedMosquito(Mosquito* m);
+        bool removeInfectedMosquito(Mosquito* m);
+        void clearInfectedMosquitoes();
+        static void setRanking(LocationRanking* ranking) { _ranking = ranking; } // kept up to date with infected mosquito counts
         void addNeighbor(Location *p);
         int getNumNeighbors() const { return _neighbors.size(); }
         Location *getNeighbor(int n) { return _neighbors[n]; }
         inline Person* getPerson(int idx, TimePeriod timeofday) { return _person[(int) timeofday][idx]; }
+        const int32_t* getPersonIDs(TimePeriod timeofday) const { return _personID[(int) timeofday].data(); } // parallel to getPerson()
         void setCoordinates(std::pair<double, double> c) { _coord = c; }
         std::pair<double, double> getCoordinates() { return _coord; }
         void setX(double x) { _coord.first = x; }
         void setY(double y) { _coord.second = y; }
         double getX() const { return _coord.first; }
         double getY() const { return _coord.second; }
+        size_t getPersonListBytes() const;                            // for memory accounting
+        size_t getNeighborListBytes() const { return _neighbors.capacity() * sizeof(Location*); }
+        size_t getInfectedMosquitoListBytes() const { return _infectedMosquitoes.capacity() * sizeof(Mosquito*); }
+        size_t getVectorControlQueueBytes() const { return ITQ.size() * sizeof(InsecticideTreatmentEvent); }
 
         bool operator == ( const Location* other ) const { return ( ( _ID == other->_ID ) && ( _serial == other->_serial ) ); }
 
@@ -83,11 +95,14 @@ class Location {
         LocationType _type;
         TrialArmState _trial_arm;
         bool _surveilled;
+        int _region;
         std::vector< std::vector<Person*> > _person;                  // pointers to person who come to this location
+        std::vector< std::vector<int32_t> > _personID;                // and their IDs, in the same order (TransmissionKernels.h)
         int _nBaseMosquitoCapacity;                                   // "baseline" carrying capacity for mosquitoes
-        int _currentInfectedMosquitoes;
+        std::vector<Mosquito*> _infectedMosquitoes;                   // infected mosquitoes currently at this location
         std::vector<Location*> _neighbors;
         static int _nNextSerial;                                      // unique ID to assign to the next Location allocated
+        static LocationRanking* _ranking;                             // only set if targeted vector control needs it
         std::pair<double, double> _coord;                             // (x,y) coordinates for location
 
         std::priority_queue<InsecticideTreatmentEvent> ITQ;           // insecticide treatment event priority queue
@@ -0,0 +1,164 @@
+// LocationRanking.h
+// Ranks locations of each type by mosquito burden, i.e. base mosquito capacity * capacity multiplier
+// + resident infected mosquitoes, for targeted vector control.  The multiplier is by forcing region.
+//
+// Base capacities are fixed, so each type keeps one list of locations per region sorted by capacity; within a
+// region the multiplier is the same for all locations, so the lists stay sorted by capacity * multiplier and are
+// merged on the fly.  Infected mosquito counts change constantly but are small integers, so locations with
+// infected mosquitoes are kept in buckets by count, which Location updates as mosquitoes arrive, leave, and die.
+// Top-k queries combine the two sorted views with Fagin's threshold algorithm, which stops as soon as no unseen
+// location can beat the k-th best location found so far.  Nothing is sorted after construction.
+#ifndef __LOCATION_RANKING_H
+#define __LOCATION_RANKING_H
+
+#include <vector>
+#include <queue>
+#include <algorithm>
+#include <assert.h>
+#include "Parameters.h"
+#include "Location.h"
+
+class LocationRanking {
+    public:
+        LocationRanking(const std::vector<Location*>& locations) :
+            _byCapacity(NUM_OF_LOCATION_TYPES),
+            _numRegions(1),
+            _byInfected(NUM_OF_LOCATION_TYPES, std::vector< std::vector<Location*> >(1)),
+            _bucketPosition(locations.size(), -1),
+            _seen(locations.size(), 0),
+            _query(0) {
+            for (Location* loc: locations) _numRegions = std::max(_numRegions, loc->getRegion() + 1);
+            for (auto &by_region: _byCapacity) by_region.resize(_numRegions);
+            for (Location* loc: locations) {
+                assert(loc->getID() < (signed) locations.size());   // array index is equal to the ID
+                _byCapacity[loc->getType()][loc->getRegion()].push_back(loc);
+                _moveBucket(loc, 0);
+            }
+            for (auto &by_region: _byCapacity) {
+                for (auto &ranked: by_region) {
+                    std::sort(ranked.begin(), ranked.end(), [](const Location* a, const Location* b) {
+                        return a->getBaseMosquitoCapacity() > b->getBaseMosquitoCapacity()
+                            or (a->getBaseMosquitoCapacity() == b->getBaseMosquitoCapacity() and a->getID() < b->getID()); });
+                }
+            }
+        }
+
+        int getNumRegions() const { return _numRegions; }             // regions must be assigned before construction
+
+        // called by Location after its infected mosquito count changes
+        void infectedMosquitoCountChanged(Location* loc, int old_count) { _moveBucket(loc, old_count); }
+
+        size_t getMemoryUsage() const {
+            size_t bytes = _bucketPosition.capacity() * sizeof(int) + _seen.capacity() * sizeof(unsigned int);
+            for (const auto &by_region: _byCapacity) {
+                for (const auto &ranked: by_region) bytes += sizeof(ranked) + ranked.capacity() * sizeof(Location*);
+            }
+            for (const auto &buckets: _byInfected) {
+                for (const auto &bucket: buckets) bytes += sizeof(bucket) + bucket.capacity() * sizeof(Location*);
+            }
+            return bytes;
+        }
+
+        static double burden(const Location* loc, const std::vector<double>& multiplier) {
+            return loc->getBaseMosquitoCapacity() * multiplier[loc->getRegion()] + loc->getCurrentInfectedMosquitoes();
+        }
+
+        // The (up to) k eligible locations of type t with the highest burden, highest first; ties go to lower IDs.
+        // multiplier is today's capacity multiplier by region, with at least getNumRegions() entries.
+        template <typename Predicate>
+        std::vector<Location*> top(LocationType t, unsigned int k, const std::vector<double>& multiplier, Predicate eligible) {
+            std::vector<Location*> result;
+            if (k == 0) return result;
+            assert(multiplier.size() >= (unsigned) _numRegions);
+            const std::vector< std::vector<Location*> >& by_capacity = _byCapacity[t];
+            const std::vector< std::vector<Location*> >& by_infected = _byInfected[t];
+            ++_query;                                                 // marks locations seen during this query
+
+            // the best k found so far, with the worst of them on top
+            auto better = [&multiplier](const Location* a, const Location* b) {
+                const double ba = burden(a, multiplier);
+                const double bb = burden(b, multiplier);
+                return ba > bb or (ba == bb and a->getID() < b->getID()); };
+            std::priority_queue<Location*, std::vector<Location*>, decltype(better)> best(better);
+            auto consider = [&](Location* loc) {
+                if (_seen[loc->getID()] == _query) return;
+                _seen[loc->getID()] = _query;
+                if (not eligible(loc)) return;
+                if (best.size() < k) {
+                    best.push(loc);
+                } else if (better(loc, best.top())) {
+                    best.pop();
+                    best.push(loc);
+                }
+            };
+
+            std::vector<unsigned int> c_idx(_numRegions, 0);          // cursors into by_capacity, by region
+            int bucket = by_infected.size() - 1;                      // cursor into by_infected: bucket & position
+            unsigned int b_idx = 0;
+            while (true) {
+                while (bucket > 0 and b_idx >= by_infected[bucket].size()) { --bucket; b_idx = 0; }
+                // next in the merged capacity view: the region head with the highest capacity * multiplier,
+                // ties to the lower ID, so that equal-burden locations still come in ID order
+                Location* next = nullptr;
+                double next_burden = 0.0;
+                for (int r = 0; r < _numRegions; ++r) {
+                    if (c_idx[r] >= by_capacity[r].size()) continue;
+                    Location* head = by_capacity[r][c_idx[r]];
+                    const double b = head->getBaseMosquitoCapacity() * multiplier[r];
+                    if (not next or b > next_burden or (b == next_burden and head->getID() < next->getID())) {
+                        next = head;
+                        next_burden = b;
+                    }
+                }
+                const bool capacity_done = next == nullptr;
+                const bool infected_done = bucket == 0;
+                if (capacity_done and infected_done) break;
+
+                // no unseen location can have a higher burden than this
+                const double threshold = next_burden + (infected_done ? 0 : bucket);
+                if (best.size() == k) {
+                    if (burden(best.top(), multiplier) > threshold) break;
+                    // with only the capacity view left, unseen locations come in rank order, ties included
+                    if (infected_done and not better(next, best.top())) break;
+                }
+
+                if (not infected_done) consider(by_infected[bucket][b_idx++]);
+                if (not capacity_done) { consider(next); ++c_idx[next->getRegion()]; }
+            }
+
+            result.resize(best.size());
+            for (int i = result.size() - 1; i >= 0; --i) { result[i] = best.top(); best.pop(); }
+            return result;
+        }
+
+    protected:
+        std::vector< std::vector< std::vector<Location*> > > _byCapacity; // by type & region, sorted by decreasing base capacity
+        int _numRegions;                                              // forcing regions, i.e. max region + 1
+        std::vector< std::vector< std::vector<Location*> > > _byInfected; // by type, bucketed by infected mosquito count
+                                                                      // (bucket 0, i.e. no infected mosquitoes, is not used)
+        std::vector<int> _bucketPosition;                             // position of each location (by ID) in its bucket
+        std::vector<unsigned int> _seen;                              // query in which each location was last seen
+        unsigned int _query;
+
+        void _moveBucket(Location* loc, int old_count) {
+            std::vector< std::vector<Location*> >& buckets = _byInfected[loc->getType()];
+            const int new_count = loc->getCurrentInfectedMosquitoes();
+            if (old_count > 0) {                                      // swap-and-pop out of old bucket
+                std::vector<Location*>& old_bucket = buckets[old_count];
+                const int pos = _bucketPosition[loc->getID()];
+                assert(old_bucket[pos] == loc);
+                old_bucket[pos] = old_bucket.back();
+                _bucketPosition[old_bucket[pos]->getID()] = pos;
+                old_bucket.pop_back();
+            }
+            if (new_count > 0) {
+                if (new_count >= (signed) buckets.size()) buckets.resize(new_count + 1);
+                _bucketPosition[loc->getID()] = buckets[new_count].size();
+                buckets[new_count].push_back(loc);
+            } else {
+                _bucketPosition[loc->getID()] = -1;
+            }
+            while (buckets.size() > 1 and buckets.back().empty()) buckets.pop_back();
+        }
+};
+#endif
@@ -0,0 +1,188 @@
+// Metrics.h
+// Online accumulators for the summary statistics an ABC particle reports.  Observers are registered with
+// Community::addObserver() before the run and are updated from the infection and symptom-onset events as they
+// happen, so a particle's metrics are complete when its last day ends, without copying or rescanning the daily
+// tallies.  Observers are not owned by the community.
+#ifndef __METRICS_H
+#define __METRICS_H
+
+#include <vector>
+#include <climits>
+#include <limits>
+#include <assert.h>
+#include "Parameters.h"
+#include "Location.h"
+#include "Person.h"
+
+class Mosquito;
+
+class MetricsObserver {
+    public:
+        virtual ~MetricsObserver() {}
+        virtual void dayStart(int /*day*/, const std::vector<Person*>& /*people*/) {} // before births, vaccination, etc.
+        // p->getInfection() is the new infection; mos is the infecting mosquito (null for introductions), which is only
+        // valid during the call
+        virtual void infection(const Person* /*p*/, const Mosquito* /*mos*/, Serotype /*serotype*/, int /*day*/) {}
+        virtual void symptomOnset(const Person* /*p*/, int /*day*/) {} // p->getInfection() is the symptomatic one
+        virtual void appendMetrics(std::vector<double>& metrics) const = 0;
+};
+
+// Infections or cases binned into 365-day years starting at first_day (epidemic years, if first_day is the start
+// of the season); events outside the window are ignored.  Cases are counted on the day of symptom onset, as in
+// Community::getNumNewlySymptomatic().
+class EpidemicYearCases : public MetricsObserver {
+    public:
+        enum Outcome { INFECTIONS, CASES, SEVERE_CASES, VACCINATED_CASES };
+
+        EpidemicYearCases(Outcome outcome, int first_day, int num_years, bool by_serotype = false) :
+            _outcome(outcome), _firstDay(first_day), _numYears(num_years), _bySerotype(by_serotype),
+            _counts(num_years * (by_serotype ? NUM_OF_SEROTYPES : 1), 0) { assert(num_years >= 0); }
+
+        void infection(const Person* /*p*/, const Mosquito* /*mos*/, Serotype serotype, int day) {
+            if (_outcome == INFECTIONS) _tally(serotype, day);
+        }
+
+        void symptomOnset(const Person* p, int day) {
+            if (_outcome == CASES or (_outcome == SEVERE_CASES and p->hasSevereDisease(day))
+                or (_outcome == VACCINATED_CASES and p->isVaccinated())) _tally(p->getSerotype(), day);
+        }
+
+        int numYears() const { return _numYears; }
+        const std::vector<int>& counts() const { return _counts; } // by year, or by serotype then year
+        int count(int year, Serotype serotype = NULL_SEROTYPE) const { // NULL_SEROTYPE == all serotypes
+            if (serotype != NULL_SEROTYPE) { assert(_bySerotype); return _counts[(int) serotype*_numYears + year]; }
+            if (not _bySerotype) return _counts[year];
+            int n = 0;
+            for (int s = 0; s < (int) NUM_OF_SEROTYPES; ++s) n += _counts[s*_numYears + year];
+            return n;
+        }
+
+        void appendMetrics(std::vector<double>& metrics) const { metrics.insert(metrics.end(), _counts.begin(), _counts.end()); }
+
+    private:
+        void _tally(Serotype serotype, int day) {
+            if (day < _firstDay) return;
+            const int year = (day - _firstDay) / 365;
+            if (year >= _numYears) return;
+            ++_counts[(_bySerotype ? (int) serotype*_numYears : 0) + year];
+        }
+
+        const Outcome _outcome;
+        const int _firstDay;
+        const int _numYears;
+        const bool _bySerotype;
+        std::vector<int> _counts;
+};
+
+// Fraction ever infected, by age class, at the start of day; among the given IDs (e.g. a serosurvey sample), or
+// everyone.  upper_age_bounds are inclusive, and the last should be INT_MAX.  NaN for an empty age class, or if
+// the day is never reached.
+class SeroprevalenceAt : public MetricsObserver {
+    public:
+        SeroprevalenceAt(int day, std::vector<int> upper_age_bounds = {INT_MAX}, std::vector<int> ids = {}) :
+            _day(day), _upperAgeBounds(upper_age_bounds), _ids(ids),
+            _seroprevalence(upper_age_bounds.size(), std::numeric_limits<double>::quiet_NaN()),
+            _sampleSize(upper_age_bounds.size(), 0) {
+            assert(upper_age_bounds.size() > 0);
+        }
+
+        void dayStart(int day, const std::vector<Person*>& people) {
+            if (day != _day) return;
+            std::vector<int> seropos(_upperAgeBounds.size(), 0);
+            if (_ids.size()) {
+                for (int id: _ids) { assert(id >= 0 and id < (int) people.size()); _survey(people[id], seropos); }
+            } else {
+                for (const Person* p: people) _survey(p, seropos);
+            }
+            for (unsigned int a = 0; a < seropos.size(); ++a) _seroprevalence[a] = (double) seropos[a] / _sampleSize[a];
+        }
+
+        const std::vector<double>& seroprevalence() const { return _seroprevalence; }
+        const std::vector<int>& sampleSize() const { return _sampleSize; }
+
+        void appendMetrics(std::vector<double>& metrics) const {
+            metrics.insert(metrics.end(), _seroprevalence.begin(), _seroprevalence.end());
+        }
+
+    private:
+        void _survey(const Person* p, std::vector<int>& seropos) {
+            const int age = p->getAge();
+            assert(age >= 0);
+            unsigned int a = 0;
+            while (a < _upperAgeBounds.size() - 1 and age > _upperAgeBounds[a]) ++a;
+            ++_sampleSize[a];
+            if (p->getNumNaturalInfections() > 0) ++seropos[a];
+        }
+
+        const int _day;
+        const std::vector<int> _upperAgeBounds;
+        const std::vector<int> _ids;
+        std::vector<double> _seroprevalence;
+        std::vector<int> _sampleSize;
+};
+
+// Infections, cases, and severe cases per enrolled person in each trial arm, by year from first_day.  People are
+// enrolled if their home is surveilled and they are min_age..max_age: on the day of infection for the counts (as
+// the daily-arm tallies in simulator.h), and at the start of census_day for the arm sizes.  Metrics are, for each
+// year, arm 1 {infections, cases, severe} then arm 2 {infections, cases, severe}.
+class TrialArmRates : public MetricsObserver {
+    public:
+        enum ArmOutcome { ARM_INFECTIONS, ARM_CASES, ARM_SEVERE_CASES, NUM_OF_ARM_OUTCOMES };
+
+        TrialArmRates(int first_day, int num_years, int census_day, int min_age = 2, int max_age = 15) :
+            _firstDay(first_day), _numYears(num_years), _censusDay(census_day), _minAge(min_age), _maxAge(max_age),
+            _counts(num_years * NUM_OF_ARMS * NUM_OF_ARM_OUTCOMES, 0) { _armSize[0] = _armSize[1] = 0; }
+
+        void dayStart(int day, const std::vector<Person*>& people) {
+            if (day != _censusDay) return;
+            _armSize[0] = _armSize[1] = 0;
+            for (const Person* p: people) {
+                const int arm = _arm(p);
+                if (arm >= 0) ++_armSize[arm];
+            }
+        }
+
+        void infection(const Person* p, const Mosquito* /*mos*/, Serotype /*serotype*/, int day) {
+            if (day < _firstDay or (day - _firstDay) / 365 >= _numYears) return;
+            const int arm = _arm(p);
+            if (arm < 0) return;
+            const Infection* infec = p->getInfection();
+            int* c = &_counts[(((day - _firstDay) / 365) * NUM_OF_ARMS + arm) * NUM_OF_ARM_OUTCOMES];
+            ++c[ARM_INFECTIONS];
+            c[ARM_CASES]        += infec->isSymptomatic();
+            c[ARM_SEVERE_CASES] += infec->isSevere();
+        }
+
+        int armSize(TrialArmState arm) const { assert(arm == TRIAL_ARM_1 or arm == TRIAL_ARM_2); return _armSize[(int) arm - 1]; }
+        int count(int year, TrialArmState arm, ArmOutcome outcome) const {
+            assert(arm == TRIAL_ARM_1 or arm == TRIAL_ARM_2);
+            return _counts[(year * NUM_OF_ARMS + (int) arm - 1) * NUM_OF_ARM_OUTCOMES + outcome];
+        }
+
+        void appendMetrics(std::vector<double>& metrics) const {
+            for (unsigned int i = 0; i < _counts.size(); ++i) {
+                metrics.push_back((double) _counts[i] / _armSize[(i / NUM_OF_ARM_OUTCOMES) % NUM_OF_ARMS]);
+            }
+        }
+
+    private:
+        static const int NUM_OF_ARMS = 2;
+
+        int _arm(const Person* p) const {                             // 0 or 1, or -1 if not enrolled
+            const Location* home = p->getHomeLoc();
+            const int age = p->getAge();
+            if (not home->isSurveilled() or age < _minAge or age > _maxAge) return -1;
+            const TrialArmState arm = home->getTrialArm();
+            return (arm == TRIAL_ARM_1 or arm == TRIAL_ARM_2) ? (int) arm - 1 : -1;
+        }
+
+        const int _firstDay;
+        const int _numYears;
+        const int _censusDay;
+        const int _minAge;
+        const int _maxAge;
+        std::vector<int> _counts;                                     // by year, arm, and outcome
+        int _armSize[NUM_OF_ARMS];
+};
+
+#endif
@@ -23,6 +23,10 @@ Mosquito::Mosquito() {
     _eSerotype = NULL_SEROTYPE;
     _nInfectedAtID = -1;
     _pLocation = _pOriginLocation = NULL;
+    _nLocationSlot = -1;
+    _cQueue = '\0';
+    _nQueueKey = -1;
+    _nChainIndex = -1;
 }
 
 
@@ -41,7 +45,10 @@ Mosquito::Mosquito(Location* p, Serotype serotype, int nInfectedAtID, int nExter
     _nAgeDeath = Parameters::sampler(MOSQUITO_DEATHAGE_CDF, r, _nAgeDeath);
     //cerr << _nAgeInfected << " " << _nAgeDeath << endl;
     _pLocation = _pOriginLocation = p;
-    _pLocation->addInfectedMosquito();
+    _pLocation->addInfectedMosquito(this);
+    _cQueue = '\0';
+    _nQueueKey = -1;
+    _nChainIndex = -1;
 }
 
 
@@ -51,10 +58,13 @@ Mosquito::Mosquito(RestoreMosquitoPars* rp):
     _bDead = false;
     _nInfectedAtID = -1;
     _pOriginLocation = NULL;
-    _pLocation->addInfectedMosquito();
+    _pLocation->addInfectedMosquito(this);
+    _cQueue = '\0';
+    _nQueueKey = -1;
+    _nChainIndex = -1;
 }
 
 
 Mosquito::~Mosquito() {
-    _pLocation->removeInfectedMosquito();
+    _pLocation->removeInfectedMosquito(this);
 }
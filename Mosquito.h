@@ -8,8 +8,6 @@
 #include "Location.h" 
 
 class Location;
-//Location::removeInfectedMosquito();
-//Location::addInfectedMosquito();
 
 struct RestoreMosquitoPars {
     RestoreMosquitoPars() : location(nullptr), serotype((Serotype) 0), age_infected(0), age_infectious(0), age_dead(0) {};
@@ -31,13 +29,24 @@ class Mosquito {
         int getID() const { return _nID; }
         Location* getLocation() const { return _pLocation; }
         void setLocation(Location *p) { _pLocation = p; }
-        void updateLocation(Location *p) { _pLocation->removeInfectedMosquito(); setLocation(p); p->addInfectedMosquito(); }
+        void updateLocation(Location *p) { _pLocation->removeInfectedMosquito(this); setLocation(p); p->addInfectedMosquito(this); }
         Location* getOriginLocation() const { return _pOriginLocation; }
         int getAgeInfected() const { return _nAgeInfected; }
         int getAgeInfectious() const { return _nAgeInfectious; }
         int getAgeDeath() const { return _nAgeDeath; }
         bool isDead() const { return _bDead; }
+        void kill() { _bDead = true; }                                // flags mosquito for removal from community queues
         Serotype getSerotype() const { return _eSerotype; }
+        // Community keeps mosquitoes in day-indexed queues ('e'xposed or 'i'nfectious).  The key is the queue index
+        // plus the current day, which doesn't change as the queues advance.
+        void setQueueKey(char queue, int key) { _cQueue = queue; _nQueueKey = key; }
+        char getQueue() const { return _cQueue; }
+        int getQueueKey() const { return _nQueueKey; }
+        // Position in the current location's infected mosquito list, kept by Location for O(1) removal
+        void setLocationSlot(int slot) { _nLocationSlot = slot; }
+        int getLocationSlot() const { return _nLocationSlot; }
+        long int getChainIndex() const { return _nChainIndex; }       // see TransmissionChain.h
+        void setChainIndex(long int i) { _nChainIndex = i; }
 
 
     protected:
@@ -50,6 +59,10 @@ class Mosquito {
         int _nAgeDeath;                                               // lifespan in days
         bool _bDead;                                                  // is dead?
         int _nInfectedAtID;                                           // location ID where infected
+        char _cQueue;                                                 // community queue this mosquito is in
+        int _nQueueKey;                                               // queue index + day
+        int _nLocationSlot;                                           // index in _pLocation's infected mosquito list
+        long int _nChainIndex;                                        // transmission-chain record, or -1 if none
         static int _nNextID;                                          // unique ID to assign to the next Mosquito allocated
 };
 #endif
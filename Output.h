@@ -0,0 +1,132 @@
+// Output.h
+// Sinks for the simulator's periodic (daily, weekly, ...) output.  A FileSink writes to stderr, as the simulator
+// always has, or to a per-process file; an AsyncWriter puts a background thread in front of another sink, so
+// the tick loop only copies bytes into memory and never waits on a (possibly shared, slow) filesystem.
+//
+// The AsyncWriter has two fixed-capacity buffers: the simulation thread fills the front one, and when it is full
+// (or on flush) hands it to the writer thread by swapping it with the back one, which the writer thread has
+// emptied in the meantime.  Buffered output is therefore bounded by twice the capacity, whatever the run length;
+// the simulation thread only waits if it fills a whole buffer before the previous one has been written.
+#ifndef __OUTPUT_H
+#define __OUTPUT_H
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+class OutputSink {
+    public:
+        virtual ~OutputSink() {}
+        virtual void write(const char* data, size_t n) = 0;
+        void write(const std::string &s) { write(s.data(), s.size()); }
+        virtual void flush() {}
+};
+
+class FileSink : public OutputSink {
+    public:
+        FileSink(FILE* fh) : _fh(fh), _owned(false) {}              // e.g. stderr; not closed
+        FileSink(const std::string filename, bool binary = false) : _owned(true) {
+            _fh = fopen(filename.c_str(), binary ? "wb" : "w");
+            if (not _fh) {
+                std::cerr << "ERROR: Could not open output file: " << filename << std::endl;
+                exit(-1);
+            }
+        }
+        ~FileSink() { if (_owned) fclose(_fh); else fflush(_fh); }
+
+        using OutputSink::write;
+        void write(const char* data, size_t n) {
+            if (n and fwrite(data, 1, n, _fh) != n) { std::cerr << "ERROR: Output write failed" << std::endl; exit(-1); }
+        }
+        void flush() { fflush(_fh); }
+
+    private:
+        FILE* _fh;
+        const bool _owned;
+};
+
+class AsyncWriter : public OutputSink {
+    public:
+        AsyncWriter(OutputSink* sink, size_t capacity = 1 << 20) :    // takes ownership of sink
+            _sink(sink), _capacity(capacity), _front(new char[capacity]), _back(new char[capacity]),
+            _frontSize(0), _backSize(0), _backFull(false), _stop(false), _writer(&AsyncWriter::_run, this) {}
+
+        ~AsyncWriter() {
+            flush();
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _stop = true;
+            }
+            _changed.notify_all();
+            _writer.join();
+            delete _sink;
+            delete[] _front;
+            delete[] _back;
+        }
+
+        using OutputSink::write;
+        void write(const char* data, size_t n) {
+            while (n > 0) {
+                const size_t m = std::min(n, _capacity - _frontSize);
+                memcpy(_front + _frontSize, data, m);
+                _frontSize += m;
+                data += m;
+                n -= m;
+                if (_frontSize == _capacity) _handOff();
+            }
+        }
+
+        // returns once everything written so far has reached the sink
+        void flush() {
+            if (_frontSize > 0) _handOff();
+            std::unique_lock<std::mutex> lock(_mutex);
+            _changed.wait(lock, [this]() { return not _backFull; });
+            _sink->flush();
+        }
+
+    private:
+        void _handOff() {                                             // swap buffers; no bytes are copied
+            std::unique_lock<std::mutex> lock(_mutex);
+            _changed.wait(lock, [this]() { return not _backFull; });
+            std::swap(_front, _back);
+            _backSize = _frontSize;
+            _frontSize = 0;
+            _backFull = true;
+            lock.unlock();
+            _changed.notify_all();
+        }
+
+        void _run() {
+            std::unique_lock<std::mutex> lock(_mutex);
+            while (true) {
+                _changed.wait(lock, [this]() { return _backFull or _stop; });
+                if (not _backFull) return;                            // stopping, and nothing left to write
+                lock.unlock();
+                _sink->write(_back, _backSize);                       // the simulation thread only touches _front
+                lock.lock();
+                _backFull = false;
+                _changed.notify_all();
+            }
+        }
+
+        OutputSink* _sink;
+        const size_t _capacity;
+        char* _front;                                                 // filled by the simulation thread
+        char* _back;                                                  // written out by the writer thread
+        size_t _frontSize;
+        size_t _backSize;
+        bool _backFull;
+        bool _stop;
+        std::mutex _mutex;
+        std::condition_variable _changed;
+        std::thread _writer;                                          // last, so it starts after everything above
+};
+
+#endif
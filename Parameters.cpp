@@ -44,6 +44,11 @@ void Parameters::define_defaults() {
     peopleOutputFilename = "";
     yearlyPeopleOutputFilename = "";
     dailyOutputFilename = "";
+    infectionLogFilename = "";
+    transmissionChainFilename = "";
+    rasterFilename = "";
+    rasterCellSize = 0.00416667;                        // the synthetic population's pixel size, in degrees
+    monthlyRaster = false;
     swapProbFilename = "";
     annualIntroductionsFilename = "";                   // time series of some external factor determining introduction rate
     annualIntroductionsCoef = 1;                        // multiplier to rescale external introductions to something sensible
@@ -57,6 +62,8 @@ void Parameters::define_defaults() {
     extrinsicIncubationPeriods.clear();
     extrinsicIncubationPeriods.emplace_back(0, 1, 11);  // default: 11 days (Nishiura & Halstead 2007), starting on day 0 with (reused) duration 1 day
     dailyEIPfilename = "";
+    forcingFilename = "";
+    regionFilename = "";
     simpleEIP = false;                                  // default: sample EIPs from a log-normal distribution, using expected incubation periods (Chan & Johanson 2012)
                                                         // 'true' means use EIPs literally as provided (all mosquitoes infected on day X have same EIP)
     nInitialExposed  = vector<int>(NUM_OF_SEROTYPES, 0);
@@ -99,6 +106,13 @@ void Parameters::define_defaults() {
         running_sum += COMMON_DAYS_IN_MONTH[j];
     }
 
+    reactiveInterventions.clear();
+    geographicCoordinates = true;
+    memoryReport = false;
+    traceFilename = "";
+    traceSamplingInterval = 1;
+    traceMaxEvents = 1000000;
+
     startDayOfYear = 1;
 
     dailyOutput   = false;
@@ -107,6 +121,8 @@ void Parameters::define_defaults() {
     weeklyOutput  = false;
     monthlyOutput = false;
     yearlyOutput  = false;
+    binaryDailyOutput = false;
+    asyncOutput   = false;
     simulateTrial = false;
     abcVerbose    = false;
 
@@ -202,6 +218,32 @@ void Parameters::readParameters(int argc, char* argv[]) {
                     running_sum += extrinsicIncubationPeriods[j].duration;
                 }
             }
+            else if (strcmp(argv[i], "-reactiveintervention")==0) {
+                ReactiveIntervention ri;
+                const string type = argv[++i];
+                if (type == "irs") {
+                    ri.type = REACTIVE_VECTOR_CONTROL;
+                } else if (type == "vaccination") {
+                    ri.type = REACTIVE_VACCINATION;
+                } else {
+                    cerr << "ERROR: -reactiveintervention type must be irs or vaccination, not " << type << endl;
+                    exit(-1);
+                }
+                ri.startDate        = strtol(argv[++i],end,10);
+                ri.endDate          = strtol(argv[++i],end,10);
+                ri.radius           = strtod(argv[++i],end);
+                ri.delay            = strtol(argv[++i],end,10);
+                ri.dailyCapacity    = strtol(argv[++i],end,10);
+                ri.coverage         = strtod(argv[++i],end);
+                ri.efficacy         = strtod(argv[++i],end);        // IRS; ignored for vaccination
+                ri.efficacyDuration = strtol(argv[++i],end,10);
+                ri.minAge           = strtol(argv[++i],end,10);     // vaccination; ignored for IRS
+                ri.maxAge           = strtol(argv[++i],end,10);
+                reactiveInterventions.push_back(ri);
+            }
+            else if (strcmp(argv[i], "-reportedfraction")==0) {
+                for (int j=0; j<(int) NUM_OF_INFECTION_OUTCOMES; j++) reportedFraction[j] = strtod(argv[++i],end);
+            }
             else if (strcmp(argv[i], "-daysimmune")==0) {
                 nDaysImmune = strtol(argv[++i],end,10);
             }
@@ -258,6 +300,21 @@ void Parameters::readParameters(int argc, char* argv[]) {
             else if (strcmp(argv[i], "-dailyoutputfile")==0) {
                 dailyOutputFilename = argv[++i];
             }
+            else if (strcmp(argv[i], "-infectionlogfile")==0) {
+                infectionLogFilename = argv[++i];
+            }
+            else if (strcmp(argv[i], "-transmissionchainfile")==0) {
+                transmissionChainFilename = argv[++i];
+            }
+            else if (strcmp(argv[i], "-rasterfile")==0) {
+                rasterFilename = argv[++i];
+            }
+            else if (strcmp(argv[i], "-rastercellsize")==0) {
+                rasterCellSize = strtod(argv[++i],end);
+            }
+            else if (strcmp(argv[i], "-monthlyraster")==0) {
+                monthlyRaster = true;
+            }
             else if (strcmp(argv[i], "-probfile")==0) {
                 swapProbFilename = argv[++i];
             }
@@ -279,6 +336,12 @@ void Parameters::readParameters(int argc, char* argv[]) {
                 dailyEIPfilename = argv[++i];
                 loadDailyEIP(dailyEIPfilename);
             }
+            else if (strcmp(argv[i], "-forcingfile")==0) {
+                forcingFilename = argv[++i];
+            }
+            else if (strcmp(argv[i], "-regionfile")==0) {
+                regionFilename = argv[++i];
+            }
             else if (strcmp(argv[i], "-dailyoutput")==0) {
                 dailyOutput = true;
             }
@@ -291,9 +354,33 @@ void Parameters::readParameters(int argc, char* argv[]) {
             else if (strcmp(argv[i], "-yearlyoutput")==0) {
                 yearlyOutput = true;
             }
+            else if (strcmp(argv[i], "-binarydailyoutput")==0) {
+                binaryDailyOutput = true;
+            }
+            else if (strcmp(argv[i], "-asyncoutput")==0) {
+                asyncOutput = true;
+            }
             else if (strcmp(argv[i], "-abcverbose")==0) {
                 abcVerbose = true;
             }
+            else if (strcmp(argv[i], "-planarcoordinates")==0) {
+                geographicCoordinates = false;
+            }
+            else if (strcmp(argv[i], "-memoryreport")==0) {
+                memoryReport = true;
+            }
+            else if (strcmp(argv[i], "-tracefile")==0) {
+                traceFilename = argv[++i];
+#ifndef DENGUE_INSTRUMENT
+                cerr << "WARNING: -tracefile has no effect unless built with INSTRUMENT=1" << endl;
+#endif
+            }
+            else if (strcmp(argv[i], "-traceinterval")==0) {
+                traceSamplingInterval = strtol(argv[++i],end,10);
+            }
+            else if (strcmp(argv[i], "-tracemaxevents")==0) {
+                traceMaxEvents = strtol(argv[++i],end,10);
+            }
             else {
                 cerr << "Unknown option: " << argv[i] << endl;
                 cerr << "Check arguments and formatting." << endl;
@@ -305,6 +392,7 @@ void Parameters::readParameters(int argc, char* argv[]) {
     gsl_rng_set(RNG, randomseed);
     // runlength and randomseed need to be set before calling generateAnnualSerotypes()
     if (simulateAnnualSerotypes) generateAnnualSerotypes();
+    defineSerotypeRelativeRisks();                                  // after reportedFraction
     validate_parameters();
 }
 
@@ -314,6 +402,39 @@ void Parameters::validate_parameters() {
     cerr << "location file = " << locationFilename << endl;
     cerr << "network file = " << networkFilename << endl;
     cerr << "swap probabilities file = " << swapProbFilename << endl;
+    if (traceFilename.length() > 0) {
+        cerr << "trace file = " << traceFilename << " (every " << traceSamplingInterval << " days, at most " << traceMaxEvents << " events)" << endl;
+        if (traceSamplingInterval < 1) {
+            cerr << "ERROR: -traceinterval must be at least 1" << endl;
+            exit(-1);
+        }
+    }
+    if (dailyOutputFilename.length() > 0) {
+        cerr << "periodic output file = " << dailyOutputFilename << ".<process id>" << (binaryDailyOutput ? " (binary daily records)" : "") << endl;
+    } else if (binaryDailyOutput) {
+        cerr << "ERROR: -binarydailyoutput needs -dailyoutputfile" << endl;
+        exit(-1);
+    }
+    if (infectionLogFilename.length() > 0) {
+        cerr << "infection log file = " << infectionLogFilename << ".<process id>" << endl;
+    }
+    if (transmissionChainFilename.length() > 0) {
+        cerr << "transmission chain file = " << transmissionChainFilename << ".<process id>" << endl;
+    }
+    if (rasterFilename.length() > 0) {
+        cerr << "raster file = " << rasterFilename << ".<process id> (" << (monthlyRaster ? "monthly" : "weekly") << ", cell size " << rasterCellSize << ")" << endl;
+        if (not (rasterCellSize > 0.0)) {
+            cerr << "ERROR: -rastercellsize must be positive" << endl;
+            exit(-1);
+        }
+    }
+    if (forcingFilename.length() > 0) {
+        cerr << "forcing file = " << forcingFilename << endl;
+        if (regionFilename.length() > 0) cerr << "region file = " << regionFilename << endl;
+    } else if (regionFilename.length() > 0) {
+        cerr << "ERROR: -regionfile needs -forcingfile" << endl;
+        exit(-1);
+    }
     cerr << "runlength = " << nRunLength << endl;
     cerr << "start day of year (1 is Jan 1st) = " << startDayOfYear << endl;
     cerr << "random seed = " << randomseed << endl;
@@ -413,11 +534,6 @@ void Parameters::validate_parameters() {
     if (yearlyPeopleOutputFilename.length()>0) {
         cerr << "yearly people output file = " << yearlyPeopleOutputFilename << endl;
     }
-    if (dailyOutputFilename.length()>0) {
-        cerr << "daily output file = " << dailyOutputFilename << endl;
-    } else {
-        cerr << "no daily output file" << endl;
-    }
 }
 
 
@@ -74,6 +74,12 @@ enum LocationSelectionStrategy {
     NUM_OF_LOCATION_SELECTION_STRATEGY_TYPES
 };
 
+enum ReactiveInterventionType {
+    REACTIVE_VECTOR_CONTROL,
+    REACTIVE_VACCINATION,
+    NUM_OF_REACTIVE_INTERVENTION_TYPES
+};
+
 enum InfectionOutcome {
     ASYMPTOMATIC,
     MILD,
@@ -275,11 +281,35 @@ struct DynamicParameter {
 
 
 struct CatchupVaccinationEvent {
-    CatchupVaccinationEvent(){};
-    CatchupVaccinationEvent(int a, int s, double c): age(a), simDay(s), coverage(c) {};
+    CatchupVaccinationEvent(): rolloutDuration(1) {};
+    CatchupVaccinationEvent(int a, int s, double c, int d = 1): age(a), simDay(s), coverage(c), rolloutDuration(d) {};
     int age;
     int simDay;
     double coverage;
+    int rolloutDuration;                                          // days over which the campaign reaches people, starting on simDay
+};
+
+
+// Response to each detected (i.e. reported) symptomatic case with onset in [startDate, endDate): after a delay,
+// every location within radius of the case's home is treated (IRS) or has its residents aged [minAge, maxAge]
+// vaccinated
+struct ReactiveIntervention {
+    ReactiveIntervention(){};
+    ReactiveIntervention(ReactiveInterventionType t, int s, int e, double r, int dl, int cap, double c, double eff = 0.0, int ed = 0,
+                         int mina = 0, int maxa = NUM_AGE_CLASSES-1) :
+        type(t), startDate(s), endDate(e), radius(r), delay(dl), dailyCapacity(cap), coverage(c), efficacy(eff), efficacyDuration(ed),
+        minAge(mina), maxAge(maxa) {};
+    ReactiveInterventionType type;
+    int startDate;
+    int endDate;
+    double radius;                                                // km, or coordinate units if coordinates are planar
+    int delay;                                                    // days from symptom onset to response (0: same day)
+    int dailyCapacity;                                            // max locations responded to per day; the rest wait (< 0: no limit)
+    double coverage;                                              // prob. of treating each location, or vaccinating each eligible resident
+    double efficacy;                                              // vector control only
+    int efficacyDuration;                                         // vector control only; locations aren't re-queued while treated
+    int minAge;                                                   // vaccination only; ages (years) of residents to vaccinate
+    int maxAge;
 };
 
 
@@ -375,11 +405,18 @@ public:
     std::string locationFilename;
     std::string peopleOutputFilename;
     std::string yearlyPeopleOutputFilename;
-    std::string dailyOutputFilename;
+    std::string dailyOutputFilename;                        // periodic output goes to <this>.<process id>, not stderr
+    std::string infectionLogFilename;                       // infection line list (InfectionLog.h) goes to <this>.<process id>
+    std::string transmissionChainFilename;                  // who infected whom (TransmissionChain.h) goes to <this>.<process id>
+    std::string rasterFilename;                             // incidence rasters (IncidenceRaster.h) go to <this>.<process id>
+    double rasterCellSize;                                  // raster cell width, in location coordinate units
+    bool monthlyRaster;                                     // a raster frame per month, rather than per week
     std::string swapProbFilename;
     std::string annualIntroductionsFilename;                // time series of some external factor determining introduction rate
     std::string annualSerotypeFilename;                     // time series of some external factor determining introduction rate
     std::string dailyEIPfilename;
+    std::string forcingFilename;                            // regional EIP and mosquito capacity tables (Forcing.h)
+    std::string regionFilename;                             // forcing region of each location
     std::string mosquitoFilename;
     std::string mosquitoLocationFilename;
     std::vector<double> annualIntroductions;
@@ -399,6 +436,12 @@ public:
     int vaccineTargetStartDate;
 
     std::vector<VectorControlEvent> vectorControlEvents;
+    std::vector<ReactiveIntervention> reactiveInterventions;
+    bool geographicCoordinates;                             // location x, y are longitude, latitude (distances in km)? else planar
+    bool memoryReport;                                      // report estimated memory use by subsystem, at load & yearly
+    std::string traceFilename;                              // Chrome trace-event output; needs an instrumented build
+    int traceSamplingInterval;                              // trace every n-th simulated day
+    unsigned int traceMaxEvents;                            // events past this are dropped
 
     int startDayOfYear;
     int startJulianYear;
@@ -408,6 +451,8 @@ public:
     bool weeklyOutput;
     bool monthlyOutput;
     bool yearlyOutput;
+    bool binaryDailyOutput;                                 // daily output as DailyRecords (simulator.h), to the file above
+    bool asyncOutput;                                       // periodic output is written by a background thread
     bool simulateTrial;
     bool abcVerbose;
     unsigned long int serial;
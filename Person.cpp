@@ -15,11 +15,13 @@
 #include <gsl/gsl_randist.h>
 #include "Person.h"
 #include "Community.h"
+#include "Mosquito.h"
 #include "Parameters.h"
 
 using namespace dengue::standard;
 
 int Person::_nNextID = 0;
+OccupantStates Person::_occupantStates;
 
 const Parameters* Person::_par;
 
@@ -33,6 +35,7 @@ Person::Person() {
     _bDead = false;
     _bVaccinated = false;
     _bNaiveVaccineProtection = false;
+    _syncOccupantState();
 }
 
 
@@ -51,6 +54,7 @@ Infection& Person::initializeNewInfection(Serotype serotype) {
     setImmunity(serotype);
     Infection* infection = new Infection(serotype);
     infectionHistory.push_back(infection);
+    _syncOccupantState();                                             // not yet infectious
     return *infection;
 }
 
@@ -58,7 +62,7 @@ Infection& Person::initializeNewInfection(Serotype serotype) {
 Infection& Person::initializeNewInfection(Mosquito* mos, int time, Location* loc, Serotype serotype) {
     Infection& infection     = initializeNewInfection(serotype);
     infection.infectionOwner = this;
-    infection.infectedBy     = mos; // this is a mosquito ID
+    infection.infectedByID   = mos ? mos->getID() : -1;
     infection.infectedLoc    = loc;
     infection.infectedTime   = time;
     infection.infectiousTime = Parameters::sampler(INCUBATION_CDF, gsl_rng_uniform(RNG)) + time;
@@ -79,6 +83,7 @@ void Person::copyImmunity(const Person* p) {
     for (int i=0; i < p->getNumNaturalInfections(); i++) {
         infectionHistory.push_back( new Infection(p->infectionHistory[i]) );
     }
+    _syncOccupantState();
 }
 
 
@@ -90,12 +95,14 @@ void Person::resetImmunity() {
     vaccineHistory.clear();
     _bNaiveVaccineProtection = false;
     _bDead = false;
+    _syncOccupantState();
 }
 
 
 bool Person::naturalDeath(int t) {
     if (_nLifespan<=_nAge+(t/365.0)) {
         _bDead = true;
+        _syncOccupantState();
         return true;
     }
     return false;
@@ -104,6 +111,17 @@ bool Person::naturalDeath(int t) {
 
 void Person::kill() {
     _bDead = true;
+    _syncOccupantState();
+}
+
+
+void Person::_syncOccupantState() {
+    if (_nID >= (signed) _occupantStates.vaccinated.size()) _occupantStates.resize(std::max(2*_occupantStates.vaccinated.size(), (size_t) _nID + 1));
+    const bool current = infectionHistory.size() > 0 and not _bDead;
+    _occupantStates.infectious_from[_nID] = current ? infectionHistory.back()->infectiousTime : INT_MIN;
+    _occupantStates.infectious_to[_nID]   = current ? infectionHistory.back()->recoveryTime : INT_MIN;
+    _occupantStates.serotype[_nID]        = current ? (int) infectionHistory.back()->serotype() : 0;
+    _occupantStates.vaccinated[_nID]      = _bVaccinated;
 }
 
 
@@ -279,6 +297,7 @@ bool Person::infect(Mosquito* mos, int time, Location* loc, Serotype serotype) {
     // if the antibody-primed vaccine-induced immunity can be acquired retroactively, upgrade this person from naive to mature
     if (_par->bRetroactiveMatureVaccine) _bNaiveVaccineProtection = false;
 
+    _syncOccupantState();
     return true;
 }
 
@@ -418,6 +437,7 @@ bool Person::vaccinate(int time) {
                 }
             }
         }
+        _syncOccupantState();
         return true;
     } else {
         return false;
@@ -8,6 +8,7 @@
 #include <climits>
 #include "Parameters.h"
 #include "Location.h"
+#include "TransmissionKernels.h"
 
 class Location;
 class Mosquito;
@@ -15,7 +16,7 @@ class Mosquito;
 class Infection {
     friend class Person;
     Infection() {
-        infectedBy     = nullptr;
+        infectedByID   = -1;
         infectedLoc    = nullptr;
         infectionOwner = nullptr;
         infectedTime   = INT_MIN;
@@ -29,7 +30,7 @@ class Infection {
     };
 
     Infection(const Serotype sero) {
-        infectedBy     = nullptr;
+        infectedByID   = -1;
         infectedLoc    = nullptr;
         infectionOwner = nullptr;
         infectedTime   = INT_MIN;
@@ -43,7 +44,7 @@ class Infection {
     };
 
     Infection(const Infection* o) {
-        infectedBy     = o->infectedBy;
+        infectedByID   = o->infectedByID;
         infectedLoc    = o->infectedLoc;
         infectionOwner = o->infectionOwner;
         infectedTime   = o->infectedTime;
@@ -55,9 +56,9 @@ class Infection {
         severeDisease  = o->severeDisease;
     }
 
-    Mosquito* infectedBy;                           // who infected this person
     Location* infectedLoc;                          // where infected?
     Person* infectionOwner;                         // who does this infection belong to
+    int infectedByID;                               // ID of the mosquito that infected this person; -1 for introductions
     int infectedTime;                               // when infected?
     int infectiousTime;                             // when infectious period starts
     int symptomTime;                                // when symptoms start
@@ -68,7 +69,7 @@ class Infection {
 
   public:
 
-    bool isLocallyAcquired() const { return (bool) infectedBy; }
+    bool isLocallyAcquired() const { return infectedByID >= 0; }
     int getInfectedTime()    const { return infectedTime; }
     int getInfectiousTime()  const { return infectiousTime; }
     int getSymptomTime()     const { return symptomTime; }
@@ -79,7 +80,7 @@ class Infection {
     Serotype serotype()      const { return _serotype; }
 
     Location* getInfectedLoc()  const { return infectedLoc; }
-    Mosquito* getInfectedBy()   const  { return infectedBy; }
+    int getInfectedByID()       const { return infectedByID; } // the mosquito itself may have died since
     Person* getInfectionOwner() const { return infectionOwner; }
 };
 
@@ -102,7 +103,7 @@ class Person {
         void copyImmunity(const Person *p);
         void resetImmunity();
         void appendToSwapProbabilities(std::pair<int, double> p) { _swap_probabilities.push_back(p); }
-        std::vector<std::pair<int, double> > getSwapProbabilities() const { return _swap_probabilities; }
+        const std::vector<std::pair<int, double> >& getSwapProbabilities() const { return _swap_probabilities; }
 
         bool isSusceptible(Serotype serotype) const;                  // is susceptible to serotype (and is alive)
         bool isCrossProtected(int time) const;
@@ -111,7 +112,7 @@ class Person {
         inline Location* getLocation(TimePeriod timeofday) const { return _pLocation[(int) timeofday]; }
         inline void setLocation(Location* p, TimePeriod timeofday) { _pLocation[(int) timeofday] = p; }
 
-        inline Mosquito* getInfectedBy(int infectionsago=0) const  { return getInfection(infectionsago)->infectedBy; }
+        inline int getInfectedByID(int infectionsago=0) const  { return getInfection(infectionsago)->infectedByID; }
         inline Location* getInfectedLoc(int infectionsago=0) const { return getInfection(infectionsago)->infectedLoc; }
         inline int getInfectedTime(int infectionsago=0) const      { return getInfection(infectionsago)->infectedTime; }
         inline int getInfectiousTime(int infectionsago=0) const    { return getInfection(infectionsago)->infectiousTime; }
@@ -121,7 +122,7 @@ class Person {
         inline Serotype getSerotype(int infectionsago=0) const     { return getInfection(infectionsago)->serotype(); }
         const Infection* getInfection(int infectionsago=0) const   { return infectionHistory[getNumNaturalInfections() - 1 - infectionsago]; }
 
-        inline void setRecoveryTime(int time, int infectionsago=0) { infectionHistory[getNumNaturalInfections() - 1 - infectionsago]->recoveryTime = time; }
+        inline void setRecoveryTime(int time, int infectionsago=0) { infectionHistory[getNumNaturalInfections() - 1 - infectionsago]->recoveryTime = time; _syncOccupantState(); }
         bool isWithdrawn(int time) const;                             // at home sick?
         inline int getNumNaturalInfections() const { return infectionHistory.size(); }
         inline int getEffectiveNumInfections() const {
@@ -170,7 +171,8 @@ class Person {
         Infection& initializeNewInfection(Serotype serotype);
         Infection& initializeNewInfection(Mosquito* mos, int time, Location* loc, Serotype serotype);
 
-        static void reset_ID_counter() { _nNextID = 1; }
+        static void reset_ID_counter() { _nNextID = 0; }               // IDs are zero-based, as in the population file
+        static const OccupantStates& getOccupantStates() { return _occupantStates; } // everyone's, by ID
 
     protected:
         int _nID;                                                     // unique identifier
@@ -189,8 +191,10 @@ class Person {
         std::vector<Infection*> infectionHistory;
         std::vector<int> vaccineHistory;
         void clearInfectionHistory();
+        void _syncOccupantState();                                    // after any change to infection, vaccination, or death
 
         static const Parameters* _par;
         static int _nNextID;                                          // unique ID to assign to the next Person allocated
+        static OccupantStates _occupantStates;
 };
 #endif
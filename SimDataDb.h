@@ -0,0 +1,107 @@
+// SimDataDb.h
+// Writes per-serial simulation dumps (sim_data_<serial>.sqlite) in-process through the SQLite C API: one prepared
+// insert per table, bound and stepped row by row inside a single transaction, with the database in WAL mode.
+// Nothing goes through intermediate CSV files or the sqlite3 shell.
+//
+// Needs sqlite3.h on the include path and SQLite linked in (e.g. AbcSmc's sqlite3.o), so it is not included by
+// simulator.h; experiments that dump data include it themselves.
+#ifndef __SIM_DATA_DB_H
+#define __SIM_DATA_DB_H
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <sqlite3.h>
+#include "Parameters.h"
+#include "Person.h"
+#include "Mosquito.h"
+#include "Location.h"
+#include "Community.h"
+#include "Instrumentation.h"
+
+class SimDataDb {
+    public:
+        SimDataDb(const std::string filename) : _filename(filename), _db(nullptr) {
+            if (sqlite3_open(filename.c_str(), &_db) != SQLITE_OK) _fail("open");
+            exec("PRAGMA journal_mode = WAL");
+            exec("PRAGMA synchronous = NORMAL");
+        }
+
+        ~SimDataDb() { sqlite3_close(_db); }
+
+        void exec(const std::string sql) {
+            char* msg = nullptr;
+            if (sqlite3_exec(_db, sql.c_str(), nullptr, nullptr, &msg) != SQLITE_OK) {
+                const std::string err = msg ? msg : "";
+                sqlite3_free(msg);
+                _fail(sql + ": " + err);
+            }
+        }
+
+        // One row per natural infection, people in ID order and infections oldest first.  inf_id numbers the rows
+        // in that order, so it is the same for the same simulation state (unlike the Infection* values that were
+        // written before).  inf_by_id is the infecting mosquito's ID, -1 for introductions.
+        void writeInfectionHistory(const Community* community) {
+            exec("DROP TABLE IF EXISTS infection_history");
+            exec("CREATE TABLE infection_history (inf_id INTEGER PRIMARY KEY, inf_place_id INTEGER, inf_by_id INTEGER, "
+                 "inf_owner_id INTEGER, infected_time INTEGER, infectious_time INTEGER, symptom_time INTEGER, "
+                 "recovery_time INTEGER, withdrawn_time INTEGER, severe INTEGER, serotype INTEGER)");
+            sqlite3_stmt* insert = _prepare("INSERT INTO infection_history VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
+
+            exec("BEGIN TRANSACTION");
+            sqlite3_int64 inf_id = 0;
+            for (const Person* p: community->getPeople()) {
+                for (const Infection* inf: p->getInfectionHistory()) {
+                    if (not inf) { continue; }
+                    sqlite3_bind_int64(insert, 1, inf_id++);
+                    sqlite3_bind_int(insert, 2, inf->getInfectedLoc() ? inf->getInfectedLoc()->getID() : -1);
+                    sqlite3_bind_int(insert, 3, inf->getInfectedByID());
+                    sqlite3_bind_int(insert, 4, inf->getInfectionOwner() ? inf->getInfectionOwner()->getID() : -1);
+                    sqlite3_bind_int(insert, 5, inf->getInfectedTime());
+                    sqlite3_bind_int(insert, 6, inf->getInfectiousTime());
+                    sqlite3_bind_int(insert, 7, inf->getSymptomTime());
+                    sqlite3_bind_int(insert, 8, inf->getRecoveryTime());
+                    sqlite3_bind_int(insert, 9, inf->getWithdrawnTime());
+                    sqlite3_bind_int(insert, 10, inf->isSevere());
+                    sqlite3_bind_int(insert, 11, (int) inf->serotype());
+                    if (sqlite3_step(insert) != SQLITE_DONE) _fail("insert into infection_history");
+                    sqlite3_reset(insert);
+                }
+            }
+            exec("COMMIT");
+            sqlite3_finalize(insert);
+        }
+
+    private:
+        sqlite3_stmt* _prepare(const std::string sql) {
+            sqlite3_stmt* stmt = nullptr;
+            if (sqlite3_prepare_v2(_db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) _fail(sql);
+            return stmt;
+        }
+
+        void _fail(const std::string what) {
+            std::cerr << "ERROR: SQLite failed (" << what << ") on " << _filename << ": " << sqlite3_errmsg(_db) << std::endl;
+            exit(-1);
+        }
+
+        const std::string _filename;
+        sqlite3* _db;
+};
+
+// Dumps the named tables to sim_data_<serial>.sqlite, replacing any earlier versions of them
+inline void generate_sim_data_db(const Parameters* /*par*/, const Community* community, const unsigned long int serial, std::vector<std::string> tables) {
+    const std::string filename = "sim_data_" + std::to_string(serial) + ".sqlite";
+    INSTRUMENT_IO("simulation data: " + filename);
+    SimDataDb db(filename);
+    for (const std::string &table: tables) {
+        if (table == "infection_history") {
+            db.writeInfectionHistory(community);
+        } else {
+            std::cerr << "ERROR: Unknown simulation data table: " << table << std::endl;
+            exit(-1);
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,201 @@
+// SpatialIndex.h
+// Uniform grid over location coordinates, for radius, nearest-neighbor, and bounding-box queries, and for
+// processing locations tile by tile.
+//
+// Coordinates are either geographic (x = longitude, y = latitude, in decimal degrees; distances in km) or planar
+// (distances in coordinate units).  Cells are square in coordinate units and sized so that each holds a few
+// locations on average.  Locations are stored contiguously by cell and, within a cell, by ID, so every query
+// visits memory in a predictable order and gives deterministic results.
+#ifndef __SPATIAL_INDEX_H
+#define __SPATIAL_INDEX_H
+
+#include <vector>
+#include <queue>
+#include <utility>
+#include <algorithm>
+#include <cmath>
+#include <assert.h>
+#include "Parameters.h"
+#include "Location.h"
+
+class SpatialIndex {
+    public:
+        SpatialIndex() : _geographic(true), _cellSize(1.0), _xMin(0.0), _yMin(0.0), _nx(0), _ny(0), _minCosLat(1.0) {}
+
+        void build(const std::vector<Location*>& locations, bool geographic, double locations_per_cell = 4.0) {
+            _geographic = geographic;
+            _cellLocations.clear();
+            _cellStart.clear();
+            _nx = _ny = 0;
+            if (locations.size() == 0) return;
+
+            double x_max, y_max;
+            _xMin = x_max = locations[0]->getX();
+            _yMin = y_max = locations[0]->getY();
+            for (const Location* loc: locations) {
+                _xMin = std::min(_xMin, loc->getX()); x_max = std::max(x_max, loc->getX());
+                _yMin = std::min(_yMin, loc->getY()); y_max = std::max(y_max, loc->getY());
+            }
+            const double width  = std::max(x_max - _xMin, 1e-9);
+            const double height = std::max(y_max - _yMin, 1e-9);
+            _cellSize = std::sqrt(width * height * locations_per_cell / locations.size());
+            _cellSize = std::max(_cellSize, std::max(width, height) / MAX_CELLS_PER_SIDE);
+            _nx = (int) (width / _cellSize) + 1;
+            _ny = (int) (height / _cellSize) + 1;
+            const double max_abs_lat = std::max(std::fabs(_yMin), std::fabs(y_max));
+            _minCosLat = _geographic ? std::cos(std::min(max_abs_lat, 89.0) * DEG_TO_RAD) : 1.0;
+
+            // counting sort into cells; locations are visited by ID, so each cell's list stays sorted by ID
+            std::vector<Location*> by_id(locations);
+            std::sort(by_id.begin(), by_id.end(), [](const Location* a, const Location* b) { return a->getID() < b->getID(); });
+            _cellStart.assign(_nx * _ny + 1, 0);
+            for (const Location* loc: by_id) ++_cellStart[_cell(loc->getX(), loc->getY()) + 1];
+            for (unsigned int c = 1; c < _cellStart.size(); ++c) _cellStart[c] += _cellStart[c-1];
+            std::vector<int> fill(_cellStart.begin(), _cellStart.end() - 1);
+            _cellLocations.resize(by_id.size());
+            for (Location* loc: by_id) _cellLocations[fill[_cell(loc->getX(), loc->getY())]++] = loc;
+        }
+
+        bool isGeographic() const { return _geographic; }
+
+        // km if geographic, coordinate units otherwise
+        double distance(double x1, double y1, double x2, double y2) const {
+            return _geographic ? dengue::util::haversine(x1, y1, x2, y2) : std::hypot(x2 - x1, y2 - y1);
+        }
+        double distance(const Location* a, const Location* b) const { return distance(a->getX(), a->getY(), b->getX(), b->getY()); }
+
+        // Calls f(loc) for each location within distance r of (x, y), tile by tile
+        template <typename Function>
+        void forEachWithinRadius(double x, double y, double r, Function f) const {
+            if (_nx == 0 or r < 0) return;
+            const double dy = r / _unitsToDistanceY();
+            const double dx = r / _unitsToDistanceX(y, dy);
+            _forEachCellInBox(x - dx, y - dy, x + dx, y + dy, [&](int c) {
+                for (int i = _cellStart[c]; i < _cellStart[c+1]; ++i) {
+                    Location* loc = _cellLocations[i];
+                    if (distance(x, y, loc->getX(), loc->getY()) <= r) f(loc);
+                }
+            });
+        }
+
+        // Locations within distance r of (x, y), in order of ID
+        std::vector<Location*> withinRadius(double x, double y, double r) const {
+            std::vector<Location*> result;
+            forEachWithinRadius(x, y, r, [&result](Location* loc) { result.push_back(loc); });
+            _sortByID(result);
+            return result;
+        }
+        std::vector<Location*> withinRadius(const Location* center, double r) const { return withinRadius(center->getX(), center->getY(), r); }
+
+        // Locations with x_min <= x <= x_max and y_min <= y <= y_max, in order of ID
+        std::vector<Location*> inBox(double x_min, double y_min, double x_max, double y_max) const {
+            std::vector<Location*> result;
+            if (_nx == 0) return result;
+            _forEachCellInBox(x_min, y_min, x_max, y_max, [&](int c) {
+                for (int i = _cellStart[c]; i < _cellStart[c+1]; ++i) {
+                    Location* loc = _cellLocations[i];
+                    if (loc->getX() >= x_min and loc->getX() <= x_max and loc->getY() >= y_min and loc->getY() <= y_max) result.push_back(loc);
+                }
+            });
+            _sortByID(result);
+            return result;
+        }
+
+        // The k locations nearest (x, y), nearest first; ties go to lower IDs
+        std::vector<Location*> nearest(double x, double y, unsigned int k) const {
+            std::vector<Location*> result;
+            if (_nx == 0 or k == 0) return result;
+            typedef std::pair<double, Location*> Candidate;
+            auto closer = [](const Candidate& a, const Candidate& b) {
+                return a.first < b.first or (a.first == b.first and a.second->getID() < b.second->getID()); };
+            std::priority_queue<Candidate, std::vector<Candidate>, decltype(closer)> best(closer); // farthest on top
+
+            const int cx = _clamp((int) std::floor((x - _xMin) / _cellSize), _nx);
+            const int cy = _clamp((int) std::floor((y - _yMin) / _cellSize), _ny);
+            const int max_ring = std::max(std::max(cx, _nx - 1 - cx), std::max(cy, _ny - 1 - cy));
+            for (int ring = 0; ring <= max_ring; ++ring) {
+                // anything in this ring or beyond is at least (ring - 1) cells away from (x, y), if (x, y) is in the grid;
+                // for geographic coordinates, east-west distances are scaled down conservatively
+                if (best.size() == k and ring > 1) {
+                    const double bound = (ring - 1) * _cellSize * (_geographic ? _unitsToDistanceY() * _minCosLat : 1.0);
+                    if (_insideGrid(x, y) and best.top().first < bound) break;
+                }
+                for (int gy = cy - ring; gy <= cy + ring; ++gy) {
+                    if (gy < 0 or gy >= _ny) continue;
+                    const bool edge_row = (gy == cy - ring or gy == cy + ring);
+                    for (int gx = cx - ring; gx <= cx + ring; gx += (edge_row ? 1 : 2*ring)) {
+                        if (gx >= 0 and gx < _nx) {
+                            const int c = gy * _nx + gx;
+                            for (int i = _cellStart[c]; i < _cellStart[c+1]; ++i) {
+                                Candidate cand(distance(x, y, _cellLocations[i]->getX(), _cellLocations[i]->getY()), _cellLocations[i]);
+                                if (best.size() < k) {
+                                    best.push(cand);
+                                } else if (closer(cand, best.top())) {
+                                    best.pop();
+                                    best.push(cand);
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+            result.resize(best.size());
+            for (int i = result.size() - 1; i >= 0; --i) { result[i] = best.top().second; best.pop(); }
+            return result;
+        }
+
+        // Tiles are grid cells; iterating over tiles visits every location once, in spatially coherent order
+        int getNumTiles() const { return _nx * _ny; }
+        int getNumLocationsInTile(int tile) const { return _cellStart[tile+1] - _cellStart[tile]; }
+        Location* const* tileBegin(int tile) const { return _cellLocations.data() + _cellStart[tile]; }
+        Location* const* tileEnd(int tile) const { return _cellLocations.data() + _cellStart[tile+1]; }
+        const std::vector<Location*>& getLocationsByTile() const { return _cellLocations; }
+        double getTileWidth() const { return _cellSize; }           // in coordinate units
+
+        size_t getMemoryUsage() const { return _cellStart.capacity() * sizeof(int) + _cellLocations.capacity() * sizeof(Location*); }
+
+    protected:
+        static constexpr double DEG_TO_RAD = M_PI / 180.0;
+        static constexpr int MAX_CELLS_PER_SIDE = 4096;
+
+        bool _geographic;
+        double _cellSize;                                             // in coordinate units
+        double _xMin, _yMin;
+        int _nx, _ny;                                                 // grid dimensions
+        double _minCosLat;                                            // smallest cos(latitude) within the grid
+        std::vector<int> _cellStart;                                  // locations in cell c are [_cellStart[c], _cellStart[c+1])
+        std::vector<Location*> _cellLocations;
+
+        static int _clamp(int i, int n) { return i < 0 ? 0 : i >= n ? n - 1 : i; }
+        int _cell(double x, double y) const {
+            return _clamp((int) ((y - _yMin) / _cellSize), _ny) * _nx + _clamp((int) ((x - _xMin) / _cellSize), _nx);
+        }
+        bool _insideGrid(double x, double y) const {
+            return x >= _xMin and x <= _xMin + _nx * _cellSize and y >= _yMin and y <= _yMin + _ny * _cellSize;
+        }
+
+        // distance per coordinate unit, along y and (conservatively, over latitudes y +/- dy) along x
+        double _unitsToDistanceY() const { return _geographic ? dengue::util::EARTH_RADIUS_KM * DEG_TO_RAD : 1.0; }
+        double _unitsToDistanceX(double y, double dy) const {
+            if (not _geographic) return 1.0;
+            const double max_abs_lat = std::min(std::max(std::fabs(y - dy), std::fabs(y + dy)), 89.0);
+            return _unitsToDistanceY() * std::cos(max_abs_lat * DEG_TO_RAD);
+        }
+
+        template <typename Function>
+        void _forEachCellInBox(double x_min, double y_min, double x_max, double y_max, Function f) const {
+            if (x_max < _xMin or y_max < _yMin or x_min > _xMin + _nx * _cellSize or y_min > _yMin + _ny * _cellSize) return;
+            const int gx0 = _clamp((int) std::floor((x_min - _xMin) / _cellSize), _nx);
+            const int gx1 = _clamp((int) std::floor((x_max - _xMin) / _cellSize), _nx);
+            const int gy0 = _clamp((int) std::floor((y_min - _yMin) / _cellSize), _ny);
+            const int gy1 = _clamp((int) std::floor((y_max - _yMin) / _cellSize), _ny);
+            for (int gy = gy0; gy <= gy1; ++gy) {
+                for (int gx = gx0; gx <= gx1; ++gx) f(gy * _nx + gx);
+            }
+        }
+
+        static void _sortByID(std::vector<Location*>& locs) {
+            std::sort(locs.begin(), locs.end(), [](const Location* a, const Location* b) { return a->getID() < b->getID(); });
+        }
+};
+#endif
@@ -0,0 +1,158 @@
+// TransmissionChain.h
+// Who infected whom: one record per mosquito infection (day, mosquito ID, location, serotype, and the source
+// candidates -- everyone viremic with that serotype at the location that day) and one per human infection (day,
+// person, location, serotype, and the index of the infecting mosquito's record).  Following a human record to its
+// mosquito record and on to the candidates' own infections gives the full human->mosquito->human tree, without
+// keeping mosquitoes (which are deleted when they die) or people's infection histories around.
+//
+// Records are kept in memory column by column and written out as one block per 365 simulated days, so memory is
+// bounded by a year of transmission.  Mosquito record indices count from the start of the run, across blocks;
+// source candidates are stored once per location, day, and serotype.  Candidates are the IDs people had that day;
+// as immune states (current infections included) move between people at birthdays, a candidate's own infection
+// may have been recorded under another ID.  decode_transmission converts the file to CSV.
+#ifndef __TRANSMISSION_CHAIN_H
+#define __TRANSMISSION_CHAIN_H
+
+#include <cstdint>
+#include <climits>
+#include <algorithm>
+#include <vector>
+#include "Output.h"
+#include "Person.h"
+#include "Mosquito.h"
+#include "Location.h"
+
+// The file starts with a TransmissionChainHeader.  Each block is a TransmissionChainBlock followed by its columns,
+// in native byte order: the mosquito columns (day, mosquito_id, location, serotype, sources_begin, sources_count),
+// the sources column, then the human columns (day, person, location, serotype, mosquito_record).
+struct TransmissionChainHeader {
+    char magic[8];                                                    // "DENCHAIN"
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t serial;
+};
+
+struct TransmissionChainBlock {
+    int32_t first_day;
+    int32_t last_day;
+    int64_t first_mosquito_record;                                    // index of this block's first mosquito record
+    uint64_t num_mosquito_records;
+    uint64_t num_sources;
+    uint64_t num_human_records;
+};
+
+class TransmissionChain {
+    public:
+        static const int64_t INTRODUCTION = -1;                       // mosquito_record of an introduced infection
+        static const int64_t UNKNOWN_MOSQUITO = -2;                   // infected before recording started, or restored
+
+        TransmissionChain(OutputSink* sink, uint64_t serial) :        // takes ownership of sink
+            _sink(sink), _firstDay(INT_MIN), _lastDay(INT_MIN), _firstMosquitoRecord(0), _lastSourceDay(-1),
+            _lastSourceLoc(-1), _lastSourceSerotype(-1), _lastSourcesBegin(0), _lastSourcesCount(0) {
+            TransmissionChainHeader header = {{'D', 'E', 'N', 'C', 'H', 'A', 'I', 'N'}, 1, 0, serial};
+            _sink->write((const char*) &header, sizeof(header));
+        }
+
+        ~TransmissionChain() { flush(); delete _sink; }
+
+        void dayStart(int day) {                                      // a block per 365 days
+            if (_firstDay == INT_MIN) {
+                _firstDay = day;
+            } else if (day - _firstDay >= 365) {
+                flush();
+                _firstDay = day;
+            }
+            _lastDay = day;
+        }
+
+        // Records that mos was infected at loc today; sources are the viremic people there with mos's serotype, in
+        // any order.  Sets mos's chain index, which is how human infections refer to this record.
+        void mosquitoInfection(Mosquito* mos, const Location* loc, const std::vector<Person*>& sources, int day) {
+            const int serotype = (int) mos->getSerotype();
+            if (day != _lastSourceDay or loc->getID() != _lastSourceLoc or serotype != _lastSourceSerotype) {
+                _lastSourceDay = day;
+                _lastSourceLoc = loc->getID();
+                _lastSourceSerotype = serotype;
+                _lastSourcesBegin = _sources.size();
+                for (const Person* p: sources) _sources.push_back(p->getID());
+                std::sort(_sources.begin() + _lastSourcesBegin, _sources.end());
+                _sources.erase(std::unique(_sources.begin() + _lastSourcesBegin, _sources.end()), _sources.end());
+                _lastSourcesCount = _sources.size() - _lastSourcesBegin;
+            }
+            mos->setChainIndex(_firstMosquitoRecord + _mos.day.size());
+            _mos.day.push_back(day);
+            _mos.mosquito_id.push_back(mos->getID());
+            _mos.location.push_back(loc->getID());
+            _mos.serotype.push_back(serotype);
+            _mos.sources_begin.push_back(_lastSourcesBegin);
+            _mos.sources_count.push_back(_lastSourcesCount);
+        }
+
+        // p->getInfection() is the new infection; mos is null for introductions
+        void humanInfection(const Person* p, const Mosquito* mos, Serotype serotype, int day) {
+            const Location* loc = p->getInfection()->getInfectedLoc();
+            _hum.day.push_back(day);
+            _hum.person.push_back(p->getID());
+            _hum.location.push_back(loc ? loc->getID() : p->getHomeLoc()->getID());
+            _hum.serotype.push_back((int8_t) serotype);
+            int64_t record = UNKNOWN_MOSQUITO;
+            if (not mos) {
+                record = INTRODUCTION;
+            } else if (mos->getChainIndex() >= 0) {
+                record = mos->getChainIndex();
+            }
+            _hum.mosquito_record.push_back(record);
+        }
+
+        void flush() {
+            TransmissionChainBlock block = {_firstDay, _lastDay, _firstMosquitoRecord, _mos.day.size(), _sources.size(), _hum.day.size()};
+            if (block.num_mosquito_records + block.num_human_records > 0) {
+                _sink->write((const char*) &block, sizeof(block));
+                _write(_mos.day); _write(_mos.mosquito_id); _write(_mos.location); _write(_mos.serotype);
+                _write(_mos.sources_begin); _write(_mos.sources_count);
+                _write(_sources);
+                _write(_hum.day); _write(_hum.person); _write(_hum.location); _write(_hum.serotype); _write(_hum.mosquito_record);
+            }
+            _firstMosquitoRecord += _mos.day.size();
+            _mos = MosquitoColumns();
+            _hum = HumanColumns();
+            std::vector<int32_t>().swap(_sources);
+            _lastSourceDay = -1;                                      // sources don't span blocks
+            _sink->flush();
+        }
+
+    private:
+        struct MosquitoColumns {
+            std::vector<int32_t> day;
+            std::vector<int32_t> mosquito_id;
+            std::vector<int32_t> location;                            // where infected
+            std::vector<int8_t> serotype;
+            std::vector<uint32_t> sources_begin;                      // into _sources
+            std::vector<uint32_t> sources_count;
+        };
+
+        struct HumanColumns {
+            std::vector<int32_t> day;
+            std::vector<int32_t> person;
+            std::vector<int32_t> location;                            // where infected; home, for introductions
+            std::vector<int8_t> serotype;
+            std::vector<int64_t> mosquito_record;                     // or INTRODUCTION, UNKNOWN_MOSQUITO
+        };
+
+        template<typename T> void _write(const std::vector<T>& column) { _sink->write((const char*) column.data(), column.size()*sizeof(T)); }
+
+        OutputSink* _sink;
+        int _firstDay;                                                // of the current block; INT_MIN before the first day
+        int _lastDay;
+        int64_t _firstMosquitoRecord;                                 // index of _mos's first record
+        MosquitoColumns _mos;
+        std::vector<int32_t> _sources;                                // person IDs
+        HumanColumns _hum;
+        int _lastSourceDay;                                           // the last source candidate set, for reuse
+        int _lastSourceLoc;
+        int _lastSourceSerotype;
+        uint32_t _lastSourcesBegin;
+        uint32_t _lastSourcesCount;
+};
+
+#endif
@@ -9,6 +9,7 @@
 #include <numeric>
 #include <assert.h>
 #include <iterator>
+#include <unordered_set>
 #include <iostream>
 #include <iomanip>
 #include <fstream>
@@ -20,6 +21,7 @@ using namespace std;
 
 namespace dengue {
     namespace util {
+        const double EARTH_RADIUS_KM = 6371.0;
         vector<string> split(const string &s, char delim);
 
         inline vector<string> read_vector_file(string filename, char sep=' ') {
@@ -249,6 +251,29 @@ namespace dengue {
             return new_seq;  
         }
 
+        // Floyd's algorithm: k distinct indices drawn uniformly from [0, n), using only k random draws.
+        // Indices are returned in increasing order.
+        inline vector<int> sample_indices(const gsl_rng* RNG, int n, int k) {
+            assert(k >= 0 and k <= n);
+            unordered_set<int> chosen(2*k);
+            for (int j = n - k; j < n; ++j) {
+                const int t = gsl_rng_uniform_int(RNG, j + 1);
+                if (not chosen.insert(t).second) chosen.insert(j);
+            }
+            vector<int> indices(chosen.begin(), chosen.end());
+            sort(indices.begin(), indices.end());
+            return indices;
+        }
+
+        // Great circle distance in km between two points specified in decimal degrees
+        inline double haversine(double lon1, double lat1, double lon2, double lat2) {
+            const double deg_to_rad = M_PI / 180.0;
+            const double dlon = (lon2 - lon1) * deg_to_rad;
+            const double dlat = (lat2 - lat1) * deg_to_rad;
+            const double a = pow(sin(dlat/2),2) + cos(lat1 * deg_to_rad) * cos(lat2 * deg_to_rad) * pow(sin(dlon/2),2);
+            return 2 * EARTH_RADIUS_KM * asin(sqrt(std::min(1.0, a)));
+        }
+
         inline int parseLine(char line[]){
             int i = strlen(line);
             while (*line < '0' || *line > '9') line++;
@@ -273,6 +298,22 @@ namespace dengue {
             return result;
         }
 
+        // Any "Vm..." field of /proc/self/status (e.g. "VmRSS", "VmSize"), in KB; -1 if unavailable
+        inline int getProcStatusKB(const string field) {
+            FILE* file = fopen("/proc/self/status", "r");
+            if (not file) return -1;
+            int result = -1;
+            char line[128];
+            while (fgets(line, 128, file) != NULL) {
+                if (strncmp(line, field.c_str(), field.size()) == 0 and line[field.size()] == ':') {
+                    result = parseLine(line);
+                    break;
+                }
+            }
+            fclose(file);
+            return result;
+        }
+
         inline vector<double> cdf_from_pdf(vector<double> pdf) {
             vector<double> cdf(pdf.size());
             partial_sum(
@@ -0,0 +1,112 @@
+// decode_infections: converts an infection line list written with -infectionlogfile to CSV on stdout
+//
+// usage: decode_infections <log file> [-from day] [-to day] [-locationfile f -bbox xmin ymin xmax ymax]
+//
+// -from and -to keep infections on days from..to (inclusive).  -bbox keeps infections whose location lies in the
+// box, with coordinates from the simulator's location file (locid x y ...).
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <climits>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "InfectionLog.h"
+
+using namespace std;
+
+void usage() {
+    cerr << "usage: decode_infections <log file> [-from day] [-to day] [-locationfile f -bbox xmin ymin xmax ymax]" << endl;
+    exit(-1);
+}
+
+// in_region[locid], from the location file and bounding box
+vector<bool> load_region(const string filename, const double bbox[4]) {
+    ifstream iss(filename.c_str());
+    if (!iss) {
+        cerr << "ERROR: " << filename << " not found." << endl;
+        exit(-1);
+    }
+    vector<bool> in_region;
+    string buffer;
+    int locID;
+    double locX, locY;
+    while (getline(iss, buffer)) {
+        istringstream line(buffer);
+        if (not (line >> locID >> locX >> locY)) continue;            // e.g. a header
+        if (locID < 0) {
+            cerr << "ERROR: Negative location ID in " << filename << endl;
+            exit(-1);
+        }
+        if (locID >= (signed) in_region.size()) in_region.resize(locID + 1, false);
+        in_region[locID] = locX >= bbox[0] and locY >= bbox[1] and locX <= bbox[2] and locY <= bbox[3];
+    }
+    return in_region;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) usage();
+    const string logFilename = argv[1];
+    int from = INT_MIN, to = INT_MAX;
+    string locationFilename = "";
+    bool useBbox = false;
+    double bbox[4];
+    for (int i = 2; i < argc; ++i) {
+        if (strcmp(argv[i], "-from") == 0 and i + 1 < argc) {
+            from = strtol(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "-to") == 0 and i + 1 < argc) {
+            to = strtol(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "-locationfile") == 0 and i + 1 < argc) {
+            locationFilename = argv[++i];
+        } else if (strcmp(argv[i], "-bbox") == 0 and i + 4 < argc) {
+            for (int j = 0; j < 4; ++j) bbox[j] = strtod(argv[++i], nullptr);
+            useBbox = true;
+        } else {
+            cerr << "ERROR: Unknown or incomplete option: " << argv[i] << endl;
+            usage();
+        }
+    }
+    if (useBbox != (locationFilename.length() > 0)) {
+        cerr << "ERROR: -bbox and -locationfile go together" << endl;
+        usage();
+    }
+    const vector<bool> in_region = useBbox ? load_region(locationFilename, bbox) : vector<bool>();
+
+    FILE* fh = fopen(logFilename.c_str(), "rb");
+    if (not fh) {
+        cerr << "ERROR: " << logFilename << " not found." << endl;
+        exit(-1);
+    }
+    InfectionLogHeader header;
+    if (fread(&header, sizeof(header), 1, fh) != 1 or strncmp(header.magic, "DENINFEC", 8) != 0) {
+        cerr << "ERROR: " << logFilename << " is not an infection log" << endl;
+        exit(-1);
+    }
+    if (header.version != 1 or header.record_size != sizeof(InfectionRecord)) {
+        cerr << "ERROR: Unsupported infection log version " << header.version << " (record size " << header.record_size << ")" << endl;
+        exit(-1);
+    }
+
+    cout << "day,person,location,origin_location,age,serotype,introduction,symptomatic,severe,vaccinated" << endl;
+    vector<InfectionRecord> records(1 << 16);
+    size_t n;
+    while ((n = fread(records.data(), sizeof(InfectionRecord), records.size(), fh)) > 0) {
+        for (size_t i = 0; i < n; ++i) {
+            const InfectionRecord &r = records[i];
+            if (r.day < from or r.day > to) continue;
+            if (useBbox and (r.location_id < 0 or r.location_id >= (signed) in_region.size() or not in_region[r.location_id])) continue;
+            cout << r.day << ',' << r.person_id << ',' << r.location_id << ',' << r.origin_location_id << ','
+                 << r.age << ',' << (int) r.serotype << ','
+                 << (bool) (r.flags & InfectionRecord::INTRODUCTION) << ',' << (bool) (r.flags & InfectionRecord::SYMPTOMATIC) << ','
+                 << (bool) (r.flags & InfectionRecord::SEVERE) << ',' << (bool) (r.flags & InfectionRecord::VACCINATED) << '\n';
+        }
+    }
+    if (ferror(fh)) {
+        cerr << "ERROR: Could not read " << logFilename << endl;
+        exit(-1);
+    }
+    fclose(fh);
+    return 0;
+}
@@ -0,0 +1,122 @@
+// decode_transmission: converts a transmission-chain file written with -transmissionchainfile to CSV on stdout
+//
+// usage: decode_transmission <chain file> [-mosquitoes]
+//
+// By default there is one row per human infection, joined with the record of the mosquito that caused it: when
+// and where that mosquito was infected, and its source candidates (person IDs, separated by spaces).  mosquito_record
+// is -1 for introductions and -2 if the mosquito was not recorded.  With -mosquitoes, there is one row per mosquito
+// infection instead.
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "TransmissionChain.h"
+
+using namespace std;
+
+struct Block {
+    TransmissionChainBlock header;
+    vector<int32_t> mos_day, mos_id, mos_location;
+    vector<int8_t> mos_serotype;
+    vector<uint32_t> sources_begin, sources_count;
+    vector<int32_t> sources;
+    vector<int32_t> hum_day, hum_person, hum_location;
+    vector<int8_t> hum_serotype;
+    vector<int64_t> hum_mosquito_record;
+
+    bool hasMosquito(int64_t record) const {
+        return record >= header.first_mosquito_record and record - header.first_mosquito_record < (int64_t) header.num_mosquito_records;
+    }
+};
+
+template<typename T> void read_column(FILE* fh, vector<T>& column, uint64_t n, const string filename) {
+    column.resize(n);
+    if (fread(column.data(), sizeof(T), n, fh) != n) {
+        cerr << "ERROR: " << filename << " is truncated" << endl;
+        exit(-1);
+    }
+}
+
+bool read_block(FILE* fh, Block& b, const string filename) {
+    if (fread(&b.header, sizeof(b.header), 1, fh) != 1) return false;
+    const uint64_t nm = b.header.num_mosquito_records, nh = b.header.num_human_records;
+    read_column(fh, b.mos_day, nm, filename);
+    read_column(fh, b.mos_id, nm, filename);
+    read_column(fh, b.mos_location, nm, filename);
+    read_column(fh, b.mos_serotype, nm, filename);
+    read_column(fh, b.sources_begin, nm, filename);
+    read_column(fh, b.sources_count, nm, filename);
+    read_column(fh, b.sources, b.header.num_sources, filename);
+    read_column(fh, b.hum_day, nh, filename);
+    read_column(fh, b.hum_person, nh, filename);
+    read_column(fh, b.hum_location, nh, filename);
+    read_column(fh, b.hum_serotype, nh, filename);
+    read_column(fh, b.hum_mosquito_record, nh, filename);
+    return true;
+}
+
+void write_mosquito(const Block& b, uint64_t i) {                     // day,mosquito location,sources
+    cout << b.mos_day[i] << ',' << b.mos_location[i] << ',';
+    for (uint32_t s = 0; s < b.sources_count[i]; ++s) cout << (s ? " " : "") << b.sources[b.sources_begin[i] + s];
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2 or argc > 3 or (argc == 3 and strcmp(argv[2], "-mosquitoes") != 0)) {
+        cerr << "usage: decode_transmission <chain file> [-mosquitoes]" << endl;
+        exit(-1);
+    }
+    const string filename = argv[1];
+    const bool mosquitoes = argc == 3;
+
+    FILE* fh = fopen(filename.c_str(), "rb");
+    if (not fh) {
+        cerr << "ERROR: " << filename << " not found." << endl;
+        exit(-1);
+    }
+    TransmissionChainHeader header;
+    if (fread(&header, sizeof(header), 1, fh) != 1 or strncmp(header.magic, "DENCHAIN", 8) != 0) {
+        cerr << "ERROR: " << filename << " is not a transmission-chain file" << endl;
+        exit(-1);
+    }
+    if (header.version != 1) {
+        cerr << "ERROR: Unsupported transmission-chain version " << header.version << endl;
+        exit(-1);
+    }
+
+    if (mosquitoes) {
+        cout << "mosquito_record,mosquito_id,serotype,day,location,sources" << endl;
+    } else {
+        cout << "day,person,location,serotype,mosquito_record,mosquito_day,mosquito_location,sources" << endl;
+    }
+    // Mosquitoes live less than a year, so a human infection's mosquito is in its own block or the one before
+    Block previous, current;
+    previous.header = TransmissionChainBlock();
+    while (read_block(fh, current, filename)) {
+        if (mosquitoes) {
+            for (uint64_t i = 0; i < current.header.num_mosquito_records; ++i) {
+                cout << current.header.first_mosquito_record + i << ',' << current.mos_id[i] << ',' << (int) current.mos_serotype[i] << ',';
+                write_mosquito(current, i);
+                cout << '\n';
+            }
+        } else {
+            for (uint64_t i = 0; i < current.header.num_human_records; ++i) {
+                const int64_t record = current.hum_mosquito_record[i];
+                cout << current.hum_day[i] << ',' << current.hum_person[i] << ',' << current.hum_location[i] << ','
+                     << (int) current.hum_serotype[i] << ',' << record << ',';
+                if (current.hasMosquito(record)) {
+                    write_mosquito(current, record - current.header.first_mosquito_record);
+                } else if (previous.hasMosquito(record)) {
+                    write_mosquito(previous, record - previous.header.first_mosquito_record);
+                } else {
+                    cout << ",,";
+                }
+                cout << '\n';
+            }
+        }
+        swap(previous, current);
+    }
+    fclose(fh);
+    return 0;
+}
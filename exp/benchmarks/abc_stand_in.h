@@ -0,0 +1,139 @@
+// abc_stand_in.h
+// A local stand-in for the parts of AbcSmc that an experiment's simulator() uses, so a particle loop can be run
+// and timed without AbcSmc, MPI, or a database.  Parameter vectors are read from a text file (one particle per
+// line, values in the order of the experiment's "parameters" list, '#' starts a comment) and handed to the
+// simulator in turn, as AbcSmc::simulate_next_particles() would hand out rows of the parameters table.
+//
+// The summary statistics follow the definitions in AbcSmc's utility.h closely enough for benchmarking; they
+// are not meant to reproduce fitted metric values exactly.
+#ifndef __ABC_STAND_IN_H
+#define __ABC_STAND_IN_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace ABC {
+    typedef double float_type;
+    typedef std::vector<float_type> Col;
+
+    struct MPI_par {
+        int mpi_size;
+        int mpi_rank;
+    };
+
+    inline float_type mean(const Col &data) {
+        float_type sum = 0.0;
+        for (float_type v: data) sum += v;
+        return data.size() ? sum / data.size() : 0.0;
+    }
+
+    inline float_type variance(const Col &data, float_type _mean) {
+        if (data.size() < 2) return 0.0;
+        float_type ss = 0.0;
+        for (float_type v: data) ss += (v - _mean) * (v - _mean);
+        return ss / (data.size() - 1);
+    }
+
+    // linear interpolation between closest ranks
+    inline float_type quantile(const Col &data, double q) {
+        if (data.size() == 0) return 0.0;
+        Col sorted(data);
+        std::sort(sorted.begin(), sorted.end());
+        const double pos = q * (sorted.size() - 1);
+        const unsigned int lo = (unsigned int) pos;
+        if (lo + 1 >= sorted.size()) return sorted.back();
+        return sorted[lo] + (pos - lo) * (sorted[lo + 1] - sorted[lo]);
+    }
+
+    inline float_type skewness(const Col &data) {
+        const float_type _mean = mean(data);
+        float_type m2 = 0.0, m3 = 0.0;
+        for (float_type v: data) {
+            const float_type d = v - _mean;
+            m2 += d * d;
+            m3 += d * d * d;
+        }
+        if (data.size() == 0 or m2 == 0.0) return 0.0;
+        m2 /= data.size();
+        m3 /= data.size();
+        return m3 / pow(m2, 1.5);
+    }
+
+    // fraction of consecutive values that are on opposite sides of the median
+    inline float_type median_crossings(const Col &data) {
+        if (data.size() < 2) return 0.0;
+        const float_type _median = quantile(data, 0.5);
+        int crossings = 0;
+        int last_side = 0;
+        for (float_type v: data) {
+            const int side = v > _median ? 1 : v < _median ? -1 : 0;
+            if (side == 0) continue;
+            if (last_side != 0 and side != last_side) ++crossings;
+            last_side = side;
+        }
+        return ((float_type) crossings) / (data.size() - 1);
+    }
+}
+
+// Feeds parameter vectors from a file to a simulator with AbcSmc's simulator signature
+class LocalAbc {
+    public:
+        typedef std::vector<ABC::float_type> (*Simulator)(std::vector<ABC::float_type>, const unsigned long int rng_seed,
+                                                          const unsigned long int serial, const ABC::MPI_par*);
+
+        LocalAbc() : _simulator(nullptr) { _mp.mpi_size = 1; _mp.mpi_rank = 0; }
+
+        void read_particles(const std::string filename, unsigned int num_pars) {
+            std::ifstream in(filename.c_str());
+            if (not in) {
+                std::cerr << "ERROR: Could not open particle file: " << filename << std::endl;
+                exit(-1);
+            }
+            std::string buffer;
+            int line_no = 0;
+            while (getline(in, buffer)) {
+                ++line_no;
+                buffer = buffer.substr(0, buffer.find('#'));
+                std::istringstream line(buffer);
+                std::vector<ABC::float_type> pars;
+                ABC::float_type val;
+                while (line >> val) pars.push_back(val);
+                if (pars.size() == 0) continue;
+                if (pars.size() != num_pars) {
+                    std::cerr << "ERROR: Expected " << num_pars << " parameter values on line " << line_no << " of " << filename
+                              << ", found " << pars.size() << std::endl;
+                    exit(-1);
+                }
+                _particles.push_back(pars);
+            }
+            if (_particles.size() == 0) {
+                std::cerr << "ERROR: No particles found in " << filename << std::endl;
+                exit(-1);
+            }
+        }
+
+        void set_simulator(Simulator simulator) { _simulator = simulator; }
+        unsigned int num_particles() const { return _particles.size(); }
+
+        // Runs n particles, cycling through the file if n is larger; particle i gets serial i and seed base_seed + i
+        void simulate_next_particles(unsigned int n, unsigned long int base_seed) {
+            for (unsigned int serial = 0; serial < n; ++serial) {
+                _metrics.push_back(_simulator(_particles[serial % _particles.size()], base_seed + serial, serial, &_mp));
+            }
+        }
+
+        const std::vector< std::vector<ABC::float_type> >& metrics() const { return _metrics; }
+
+    private:
+        Simulator _simulator;
+        ABC::MPI_par _mp;
+        std::vector< std::vector<ABC::float_type> > _particles;
+        std::vector< std::vector<ABC::float_type> > _metrics;
+};
+#endif
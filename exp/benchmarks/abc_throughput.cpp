@@ -0,0 +1,367 @@
+// abc_throughput.cpp
+// End-to-end throughput of an ABC particle loop: the simulator() of exp/abc-irs_refit2 (parameter definition,
+// community construction, priming or loading immunity, simulate_abc(), and the same metrics), run by a local
+// stand-in for AbcSmc that reads parameter vectors from a file.  Reports particles/hour, with the wall time of
+// every particle split into setup (parameters, community, immunity), simulation, and metrics.
+//
+// Runs on pop-toy (optionally tiled with -scale), or on any population given with -popfile/-locfile/-netfile,
+// e.g. one written by synthetic_population/generate_population -n 1800000 for a Yucatan-scale run.  The
+// fitted run is 152 years; -years shortens it (introductions and the DDT period keep their calendar years).
+// With -reject tol, particles stop early, and return the rejection sentinel, if the 1987 serosurvey is further
+// than tol from the observed seroprevalence, or if there are no cases from 1979 through 1994.
+//
+//   ./abc_throughput [-particles abc_particles.txt] [-n particles] [-years y] [-seed n] [-out results.json]
+//                    [-toydir ../../pop-toy] [-scale k] [-workdir dir] [-eipfile f] [-mosfile f]
+//                    [-popfile f -locfile f -netfile f [-immfile f] [-swapfile f]] [-planarcoordinates]
+//                    [-reject tol]
+#include <chrono>
+#include <cstdio>
+#include <sys/stat.h>
+#include "simulator.h"
+#include "Metrics.h"
+#include "abc_stand_in.h"
+#include "toy_population.h"
+#include "yucatan_serotype_generator.h"
+
+using namespace std;
+using ABC::float_type;
+
+const int FIRST_YEAR          = 1879;                                 // inclusive
+const int FIRST_OBSERVED_YEAR = 1979;
+const int LAST_YEAR           = 2015;                                 // inclusive
+const int DDT_START           = 1956 - FIRST_YEAR;                    // simulator year 77, counting from year 1
+const int DDT_DURATION        = 23;                                   // 23 years long
+const int FITTED_DURATION     = LAST_YEAR - FIRST_OBSERVED_YEAR + 1;  // 37 for 1979-2015 inclusive
+const int FORECAST_DURATION   = 15;
+const int FULL_RUN_YEARS      = DDT_START + DDT_DURATION + FITTED_DURATION + FORECAST_DURATION;
+const unsigned int NUM_PARS   = 8;                                    // as in abc-irs_refit2.json
+const unsigned int NUM_METRICS = 21;
+const double OBSERVED_SEROPREV_87 = 0.6;                              // "seroprev" in abc-irs_refit2.json
+
+enum Step { PARAMETERS, COMMUNITY, IMMUNITY, SIMULATION, METRICS, NUM_OF_STEPS };
+const char* const STEP_NAMES[NUM_OF_STEPS] = {"parameters", "community", "immunity", "simulation", "metrics"};
+
+struct Harness {
+    Harness() : run_years(FULL_RUN_YEARS), geographic(true), seroprev_tolerance(-1.0) {}
+    int run_years;
+    bool geographic;
+    double seroprev_tolerance;                                        // negative: no early rejection
+    string eip_filename;
+    string mos_filename;
+    PopulationFiles files;
+    vector< vector<double> > seconds;                                 // [particle][step]
+    vector<int> population_sizes;
+    vector<double> simulated_years;                                   // [particle], less than run_years if rejected
+} HARNESS;
+
+static double now_seconds() {
+    return chrono::duration<double>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Ends the current step and starts the next one
+class StepTimer {
+    public:
+        StepTimer(vector<double> &seconds) : _seconds(seconds), _start(now_seconds()) { _seconds.assign(NUM_OF_STEPS, 0.0); }
+        void finish(Step step) { const double t = now_seconds(); _seconds[step] += t - _start; _start = t; }
+    private:
+        vector<double> &_seconds;
+        double _start;
+};
+
+Parameters* define_simulator_parameters(vector<double> args, const unsigned long int rng_seed, const unsigned long int serial) {
+    Parameters* par = new Parameters();
+    par->define_defaults();
+    par->serial = serial;
+
+    double _mild_RF      = args[0];
+    double _severe_RF    = args[2];
+    double _base_path    = args[3];
+    double _sec_severity = args[4];
+    double _pss_ratio    = args[5];
+    double _exp_coef     = args[6];
+    double _nmos         = args[7];
+
+    par->reportedFraction = {0.0, _mild_RF, _severe_RF};              // no asymptomatic infections are reported
+    par->randomseed              = rng_seed;
+    par->dailyOutput             = false;
+    par->monthlyOutput           = false;
+    par->yearlyOutput            = true;
+    par->abcVerbose              = true;
+    par->nRunLength              = HARNESS.run_years*365;
+    par->startDayOfYear          = 1;
+    par->birthdayInterval        = 1;
+    par->annualIntroductionsCoef = _exp_coef;
+    par->geographicCoordinates   = HARNESS.geographic;
+
+    par->defineSerotypeRelativeRisks();
+    par->basePathogenicity = _base_path;
+    par->primaryPathogenicityModel = ORIGINAL_LOGISTIC;
+    par->postSecondaryRelativeRisk = 0.1;
+
+    par->primarySevereFraction    = vector<double>(NUM_OF_SEROTYPES, _sec_severity*_pss_ratio);
+    par->secondarySevereFraction  = vector<double>(NUM_OF_SEROTYPES, _sec_severity);
+    par->tertiarySevereFraction   = vector<double>(NUM_OF_SEROTYPES, _sec_severity/5.0);
+    par->quaternarySevereFraction = vector<double>(NUM_OF_SEROTYPES, _sec_severity/5.0);
+
+    par->betaPM = 0.10;
+    par->betaMP = 0.25;
+    par->fMosquitoMove = 0.15;
+    par->mosquitoMoveModel = "weighted";
+    par->fMosquitoTeleport = 0.0;
+    par->nDefaultMosquitoCapacity = (int) _nmos;
+    par->eMosquitoDistribution = EXPONENTIAL;
+
+    par->nDaysImmune = 730;
+    par->fVESs.clear();
+    par->fVESs.resize(NUM_OF_SEROTYPES, 0);
+
+    par->nDailyExposed = generate_serotype_sequences(RNG, FIRST_YEAR, FIRST_OBSERVED_YEAR, LAST_YEAR+20, true, TRANSPOSE);
+    par->simulateAnnualSerotypes = false;
+
+    par->annualIntroductions = vector<double>(DDT_START, 1.0);
+    par->annualIntroductions.resize(DDT_START+DDT_DURATION, 0.1);    // 90% reduction in intros for 20 years
+    par->annualIntroductions.resize(FULL_RUN_YEARS, 1.0);
+
+    par->loadDailyEIP(HARNESS.eip_filename);
+    if (HARNESS.mos_filename != "") {
+        par->loadDailyMosquitoMultipliers(HARNESS.mos_filename, par->nRunLength + par->startDayOfYear);
+        for (unsigned int i = DDT_START*365; i < (DDT_START+DDT_DURATION)*365 and i < par->mosquitoMultipliers.size(); ++i) {
+            par->mosquitoMultipliers[i].value *= 0.23;                // 77% reduction in mosquitoes
+        }
+    }
+
+    par->populationFilename       = HARNESS.files.population;
+    par->immunityFilename         = "";                               // loaded separately, to time it on its own
+    par->locationFilename         = HARNESS.files.locations;
+    par->networkFilename          = HARNESS.files.network;
+    par->swapProbFilename         = HARNESS.files.swap;
+    return par;
+}
+
+// As in abc-irs_refit2, for populations without an immunity file
+void prime_population(Community* community, const gsl_rng* RNG, double p_prime) { // p_prime is per-sero, yearly probability of infection
+    for (Person* p: community->getPeople()) {
+        const int age = p->getAge();
+        const int birthday = gsl_rng_uniform_int(RNG, 365);
+        const int age_days = age*365 + birthday;
+        if (age_days == 0) continue;
+        const double p_infec = 1.0 - pow(1.0-p_prime, age);
+        for (int s = 0; s < (int) NUM_OF_SEROTYPES; ++s) {
+            if (p_infec < gsl_rng_uniform(RNG)) {
+                const int day = -1*gsl_rng_uniform_int(RNG, age_days); // negative day == before "now"/start of simulation
+                p->infect(day, (Serotype) s);
+            }
+        }
+    }
+}
+
+// Stand-ins for the Merida serosurvey samples: 8-14 year olds for 1987, everyone for 2014
+void serotested_ids(Community* community, vector<int> &ids_87, vector<int> &ids_14) {
+    for (Person* p: community->getPeople()) {
+        if (p->getAge() >= 8 and p->getAge() <= 14) ids_87.push_back(p->getID());
+        ids_14.push_back(p->getID());
+    }
+}
+
+void append_if_finite(vector<double> &vec, double val) { vec.push_back(isfinite(val) ? val : 0); }
+
+vector<double> simulator(vector<double> args, const unsigned long int rng_seed, const unsigned long int serial, const ABC::MPI_par* mp) {
+    HARNESS.seconds.push_back(vector<double>());
+    StepTimer timer(HARNESS.seconds.back());
+    gsl_rng_set(RNG, rng_seed);
+    const string process_id = to_string(serial);
+
+    const Parameters* par = define_simulator_parameters(args, rng_seed, serial);
+    const double _p95_mild_RF = args[1];
+    timer.finish(PARAMETERS);
+
+    gsl_rng_set(RNG, rng_seed);
+    Community* community = build_community(par);
+    timer.finish(COMMUNITY);
+
+    if (HARNESS.files.immunity != "") {
+        if (not community->loadImmunity(HARNESS.files.immunity)) exit(-1);
+    } else {
+        prime_population(community, RNG, 0.01);
+    }
+    vector<int> serotested_ids_87, serotested_ids_14;
+    serotested_ids(community, serotested_ids_87, serotested_ids_14);
+
+    // the fitted years, or as much of them as is simulated, tallied as cases occur
+    const int num_years = par->nRunLength/365;
+    const int fit_start = min(DDT_START+DDT_DURATION, num_years - 1);
+    const int fit_end   = min(DDT_START+DDT_DURATION+FITTED_DURATION, num_years);
+    EpidemicYearCases all_cases_obs(EpidemicYearCases::CASES, 365*fit_start, fit_end - fit_start);
+    EpidemicYearCases severe_cases_obs(EpidemicYearCases::SEVERE_CASES, 365*fit_start, fit_end - fit_start);
+    community->addObserver(&all_cases_obs);
+    community->addObserver(&severe_cases_obs);
+    timer.finish(IMMUNITY);
+
+    double seropos_87 = 0.0;
+    vector<double> seropos_14_by_age(9, 0.0);
+    vector<AbcCheckpoint> checkpoints;
+    if (HARNESS.seroprev_tolerance >= 0) {
+        const double tol = HARNESS.seroprev_tolerance;
+        checkpoints.push_back({"1987 serosurvey", 1987 - FIRST_YEAR, 99, [&]() {
+            return fabs(seropos_87 - OBSERVED_SEROPREV_87) <= tol;
+        }});
+        checkpoints.push_back({"1979-1994 cases", 1994 - FIRST_YEAR, 365, [&]() {
+            for (int y = 0; y < 1995 - FIRST_OBSERVED_YEAR and y < all_cases_obs.numYears(); ++y) {
+                if (all_cases_obs.count(y)) return true;
+            }
+            return false;
+        }});
+    }
+    int rejected_by;
+    simulate_abc(par, community, process_id, serotested_ids_87, seropos_87, serotested_ids_14, seropos_14_by_age, checkpoints, rejected_by);
+    timer.finish(SIMULATION);
+    const AbcCheckpoint* failed = rejected_by < 0 ? nullptr : &checkpoints[rejected_by];
+    HARNESS.simulated_years.push_back(failed ? failed->year + failed->julian_day / 365.0 : HARNESS.run_years);
+    if (failed) {
+        HARNESS.population_sizes.push_back(community->getNumPeople());
+        delete par;
+        delete community;
+        timer.finish(METRICS);
+        cerr << mp->mpi_rank << " rejected " << serial << " at " << failed->name << endl;
+        return abc_rejection_metrics(NUM_METRICS);
+    }
+
+    const vector<int> &all_cases = all_cases_obs.counts(), &severe_cases = severe_cases_obs.counts();
+    vector<int> mild_cases;
+    for (unsigned int i = 0; i < all_cases.size(); ++i) mild_cases.push_back(all_cases[i] - severe_cases[i]);
+
+    const int y1995_idx = min(16, (int) all_cases.size());
+    const double pre_1995_severe = accumulate(severe_cases.begin(),           severe_cases.begin()+y1995_idx, 0.0);
+    const double modern_severe   = accumulate(severe_cases.begin()+y1995_idx, severe_cases.end(), 0.0);
+    const double pre_1995_cases  = accumulate(all_cases.begin(),              all_cases.begin()+y1995_idx, 0.0);
+    const double modern_cases    = accumulate(all_cases.begin()+y1995_idx,    all_cases.end(), 0.0);
+
+    ABC::Col reported_per_cap(all_cases.size());
+    const int pop_size = community->getNumPeople();
+    for (unsigned int year = 0; year < all_cases.size(); year++) {
+        const double mild_RF = (signed) year < y1995_idx ? _p95_mild_RF : par->reportedFraction[(int) MILD];
+        const float_type total_reported = mild_cases[year] * mild_RF + severe_cases[year] * par->reportedFraction[(int) SEVERE];
+        reported_per_cap[year] = 1e5 * total_reported / pop_size;     // reported cases per 100,000
+    }
+
+    vector<double> metrics;
+    const float_type _mean = ABC::mean(reported_per_cap);
+    append_if_finite(metrics, _mean);
+    for (double q: {0.0, 0.25, 0.5, 0.75, 1.0}) append_if_finite(metrics, ABC::quantile(reported_per_cap, q));
+    append_if_finite(metrics, sqrt(ABC::variance(reported_per_cap, _mean)));
+    append_if_finite(metrics, ABC::skewness(reported_per_cap));
+    append_if_finite(metrics, ABC::median_crossings(reported_per_cap));
+    append_if_finite(metrics, seropos_87);
+    append_if_finite(metrics, pre_1995_severe / pre_1995_cases);
+    append_if_finite(metrics, modern_severe / modern_cases);
+    for (double val: seropos_14_by_age) append_if_finite(metrics, val);
+    assert(metrics.size() == NUM_METRICS);
+    HARNESS.population_sizes.push_back(pop_size);
+
+    delete par;
+    delete community;
+    timer.finish(METRICS);
+
+    const vector<double> &s = HARNESS.seconds.back();
+    cerr << mp->mpi_rank << " end " << serial << " setup " << s[PARAMETERS] + s[COMMUNITY] + s[IMMUNITY]
+         << " simulation " << s[SIMULATION] << " metrics " << s[METRICS] << endl;
+    return metrics;
+}
+
+void usage_error(const string msg) {
+    cerr << "ERROR: " << msg << endl;
+    cerr << "Usage: ./abc_throughput [-particles file] [-n particles] [-years y] [-seed n] [-out file]" << endl;
+    cerr << "                        [-toydir dir] [-scale k] [-workdir dir] [-eipfile f] [-mosfile f]" << endl;
+    cerr << "                        [-popfile f -locfile f -netfile f [-immfile f] [-swapfile f]] [-planarcoordinates]" << endl;
+    cerr << "                        [-reject tol]" << endl;
+    exit(-1);
+}
+
+void write_json(FILE* fh, unsigned long int seed, double wall_seconds, const vector< vector<double> > &metrics) {
+    const unsigned int n = HARNESS.seconds.size();
+    unsigned int rejected = 0;
+    for (const auto &m: metrics) rejected += is_abc_rejection(m);
+    const double simulated_years = accumulate(HARNESS.simulated_years.begin(), HARNESS.simulated_years.end(), 0.0);
+    vector<double> totals(NUM_OF_STEPS, 0.0);
+    for (const auto &s: HARNESS.seconds) for (int i = 0; i < NUM_OF_STEPS; ++i) totals[i] += s[i];
+    const double setup = totals[PARAMETERS] + totals[COMMUNITY] + totals[IMMUNITY];
+
+    fprintf(fh, "{\n  \"seed\": %lu,\n  \"particles\": %u,\n  \"run_years\": %d,\n  \"people\": %d,\n", seed, n, HARNESS.run_years,
+            HARNESS.population_sizes.size() ? HARNESS.population_sizes.back() : 0);
+    fprintf(fh, "  \"wall_seconds\": %.3f,\n  \"particles_per_hour\": %.2f,\n", wall_seconds, 3600.0 * n / wall_seconds);
+    fprintf(fh, "  \"rejected_early\": %u,\n", rejected);
+    fprintf(fh, "  \"seconds_per_particle\": {\"setup\": %.4f, \"simulation\": %.4f, \"metrics\": %.4f},\n", setup / n,
+            totals[SIMULATION] / n, totals[METRICS] / n);
+    fprintf(fh, "  \"setup_seconds_per_particle\": {\"%s\": %.4f, \"%s\": %.4f, \"%s\": %.4f},\n", STEP_NAMES[PARAMETERS],
+            totals[PARAMETERS] / n, STEP_NAMES[COMMUNITY], totals[COMMUNITY] / n, STEP_NAMES[IMMUNITY], totals[IMMUNITY] / n);
+    fprintf(fh, "  \"fraction_of_wall_time\": {\"setup\": %.4f, \"simulation\": %.4f, \"metrics\": %.4f},\n",
+            setup / wall_seconds, totals[SIMULATION] / wall_seconds, totals[METRICS] / wall_seconds);
+    fprintf(fh, "  \"simulated_years_per_hour\": %.1f,\n  \"per_particle\": [", 3600.0 * simulated_years / wall_seconds);
+    for (unsigned int p = 0; p < n; ++p) {
+        const vector<double> &s = HARNESS.seconds[p];
+        fprintf(fh, "%s\n    {\"serial\": %u", p ? "," : "", p);
+        for (int i = 0; i < NUM_OF_STEPS; ++i) fprintf(fh, ", \"%s\": %.4f", STEP_NAMES[i], s[i]);
+        fprintf(fh, ", \"simulated_years\": %.2f, \"rejected\": %s}", HARNESS.simulated_years[p], is_abc_rejection(metrics[p]) ? "true" : "false");
+    }
+    fprintf(fh, "\n  ]\n}\n");
+}
+
+int main(int argc, char* argv[]) {
+    string particle_filename = "abc_particles.txt";
+    string toy_dir = "../../pop-toy";
+    string work_dir = "bench_population";
+    string out_filename = "";
+    int num_particles = 0;                                            // 0: one pass through the particle file
+    int scale = 1;
+    unsigned long int seed = 5500;
+
+    for (int i = 1; i < argc; ++i) {
+        const string opt = argv[i];
+        if (opt == "-planarcoordinates") { HARNESS.geographic = false; continue; }
+        if (i + 1 >= argc) usage_error("missing value for " + opt);
+        const char* val = argv[++i];
+        if      (opt == "-particles") particle_filename = val;
+        else if (opt == "-n")        num_particles = atoi(val);
+        else if (opt == "-years")    HARNESS.run_years = atoi(val);
+        else if (opt == "-seed")     seed = strtoul(val, nullptr, 10);
+        else if (opt == "-out")      out_filename = val;
+        else if (opt == "-toydir")   toy_dir = val;
+        else if (opt == "-scale")    scale = atoi(val);
+        else if (opt == "-workdir")  work_dir = val;
+        else if (opt == "-eipfile")  HARNESS.eip_filename = val;
+        else if (opt == "-mosfile")  HARNESS.mos_filename = val;
+        else if (opt == "-popfile")  HARNESS.files.population = val;
+        else if (opt == "-locfile")  HARNESS.files.locations = val;
+        else if (opt == "-netfile")  HARNESS.files.network = val;
+        else if (opt == "-immfile")  HARNESS.files.immunity = val;
+        else if (opt == "-swapfile") HARNESS.files.swap = val;
+        else if (opt == "-reject")   HARNESS.seroprev_tolerance = atof(val);
+        else usage_error("unknown option " + opt);
+    }
+    if (scale < 1 or HARNESS.run_years < 1 or num_particles < 0) usage_error("-scale and -years must be positive, -n non-negative");
+
+    if (HARNESS.files.population == "") {
+        mkdir(work_dir.c_str(), 0755);
+        HARNESS.files = toy_population::build(toy_dir, work_dir, scale, seed);
+        HARNESS.geographic = false;
+    } else if (HARNESS.files.locations == "" or HARNESS.files.network == "") {
+        usage_error("-popfile needs -locfile and -netfile");
+    }
+    if (HARNESS.eip_filename == "") HARNESS.eip_filename = toy_dir + "/eip-toy.txt";
+
+    LocalAbc abc;
+    abc.read_particles(particle_filename, NUM_PARS);
+    abc.set_simulator(simulator);
+    const double start = now_seconds();
+    abc.simulate_next_particles(num_particles ? num_particles : abc.num_particles(), seed);
+    const double wall_seconds = now_seconds() - start;
+
+    FILE* fh = out_filename == "" ? stdout : fopen(out_filename.c_str(), "w");
+    if (not fh) {
+        cerr << "ERROR: Could not open benchmark output file: " << out_filename << endl;
+        exit(-1);
+    }
+    write_json(fh, seed, wall_seconds, abc.metrics());
+    if (fh != stdout) fclose(fh);
+    return 0;
+}
@@ -0,0 +1,248 @@
+// microbench.cpp
+// Times the simulation kernels in isolation, with a fixed seed, on pop-toy or a tiled (scaled) copy of it, or
+// on any population given with the usual -popfile/-locfile/-netfile/-immfile/-swapfile options.  Results are
+// written as JSON: ns/op and ops/sec for every kernel, plus ns/item and items/sec where an op processes a
+// variable number of items (e.g. infectious mosquitoes biting, hot locations).
+//
+// The daily kernels are the phases of Community::tick(), timed during a simulated epidemic, after a warm-up period,
+// by the model's own instrumentation (Instrumentation.h; the Makefile builds instrumented copies of the model's
+// objects for this), so they are the phases the model runs, with the same feature gating.  The rest are timed on
+// their own after the epidemic.  Compare two builds by running both with the same options.
+//
+//   ./microbench [-toydir ../../pop-toy] [-scale k] [-workdir dir] [-seed n] [-warmup days] [-days days]
+//                [-reps n] [-out results.json] [-popfile f -locfile f -netfile f [-immfile f] [-swapfile f]]
+//                [-planarcoordinates]
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <sys/stat.h>
+#include "simulator.h"
+#include "toy_population.h"
+
+using namespace std;
+
+struct Kernel {
+    Kernel() : ops(0), items(0), ns(0) {}
+    string item;                                                      // what an item is, if ops have items
+    uint64_t ops;
+    uint64_t items;
+    uint64_t ns;
+};
+
+static uint64_t now_ns() {
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Times f() as one op with n items
+template <typename Function>
+static void time_op(Kernel& k, uint64_t n_items, Function f) {
+    const uint64_t start = now_ns();
+    f();
+    k.ns += now_ns() - start;
+    ++k.ops;
+    k.items += n_items;
+}
+
+class BenchCommunity : public Community {
+    public:
+        BenchCommunity(const Parameters* par) : Community(par) {}
+
+        vector<Mosquito*> liveMosquitoes() const {
+            vector<Mosquito*> mosquitoes;
+            for (const auto &bucket: _infectiousMosquitoQueue) mosquitoes.insert(mosquitoes.end(), bucket.begin(), bucket.end());
+            for (const auto &bucket: _exposedMosquitoQueue) mosquitoes.insert(mosquitoes.end(), bucket.begin(), bucket.end());
+            return mosquitoes;
+        }
+
+        using Community::moveMosquito;
+};
+
+void usage_error(const string msg) {
+    cerr << "ERROR: " << msg << endl;
+    cerr << "Usage: ./microbench [-toydir dir] [-scale k] [-workdir dir] [-seed n] [-warmup days] [-days days] [-reps n] [-out file]" << endl;
+    cerr << "                    [-popfile f -locfile f -netfile f [-immfile f] [-swapfile f]] [-planarcoordinates]" << endl;
+    exit(-1);
+}
+
+void write_json(FILE* fh, const Parameters* par, const Community* community, const map<string, Kernel> &kernels, const double load_seconds, int scale) {
+    fprintf(fh, "{\n  \"seed\": %lu,\n  \"scale\": %d,\n  \"people\": %d,\n  \"locations\": %d,\n  \"load_seconds\": %.3f,\n  \"kernels\": [",
+            par->randomseed, scale, community->getNumPeople(), (int) community->getLocations().size(), load_seconds);
+    bool first = true;
+    for (const auto &kv: kernels) {
+        const Kernel &k = kv.second;
+        if (k.ops == 0) continue;
+        const double ns_per_op = (double) k.ns / k.ops;
+        fprintf(fh, "%s\n    {\"name\": \"%s\", \"ops\": %lu, \"total_ns\": %lu, \"ns_per_op\": %.2f, \"ops_per_sec\": %.1f",
+                first ? "" : ",", kv.first.c_str(), (unsigned long) k.ops, (unsigned long) k.ns, ns_per_op, 1e9 / ns_per_op);
+        if (k.item != "") {
+            fprintf(fh, ", \"item\": \"%s\", \"items\": %lu, \"ns_per_item\": %.2f, \"items_per_sec\": %.1f", k.item.c_str(),
+                    (unsigned long) k.items, k.items ? (double) k.ns / k.items : 0.0, k.ns ? 1e9 * k.items / k.ns : 0.0);
+        }
+        fprintf(fh, "}");
+        first = false;
+    }
+    fprintf(fh, "\n  ]\n}\n");
+}
+
+int main(int argc, char* argv[]) {
+    string toy_dir = "../../pop-toy";
+    string work_dir = "bench_population";
+    string out_filename = "";
+    int scale = 1;
+    int warmup_days = 180;
+    int bench_days = 180;
+    int reps = 1000000;
+    PopulationFiles files;
+
+    Parameters* par = new Parameters();
+    par->define_defaults();
+    par->randomseed = 5500;
+
+    for (int i = 1; i < argc; ++i) {
+        const string opt = argv[i];
+        if (opt == "-planarcoordinates") { par->geographicCoordinates = false; continue; }
+        if (i + 1 >= argc) usage_error("missing value for " + opt);
+        const char* val = argv[++i];
+        if      (opt == "-toydir")  toy_dir = val;
+        else if (opt == "-scale")   scale = atoi(val);
+        else if (opt == "-workdir") work_dir = val;
+        else if (opt == "-seed")    par->randomseed = strtoul(val, nullptr, 10);
+        else if (opt == "-warmup")  warmup_days = atoi(val);
+        else if (opt == "-days")    bench_days = atoi(val);
+        else if (opt == "-reps")    reps = atoi(val);
+        else if (opt == "-out")     out_filename = val;
+        else if (opt == "-popfile") files.population = val;
+        else if (opt == "-locfile") files.locations = val;
+        else if (opt == "-netfile") files.network = val;
+        else if (opt == "-immfile") files.immunity = val;
+        else if (opt == "-swapfile") files.swap = val;
+        else usage_error("unknown option " + opt);
+    }
+    if (scale < 1 or bench_days < 1 or reps < 1) usage_error("-scale, -days and -reps must be positive");
+
+    if (files.population == "") {
+        mkdir(work_dir.c_str(), 0755);
+        files = toy_population::build(toy_dir, work_dir, scale, par->randomseed);
+        par->geographicCoordinates = false;
+    } else if (files.locations == "" or files.network == "") {
+        usage_error("-popfile needs -locfile and -netfile");
+    }
+
+    // the toy model of run_toy.sh, with introductions scaled to the population
+    par->nRunLength = warmup_days + bench_days;
+    par->startJulianYear = 2000;
+    par->simulateAnnualSerotypes = false;
+    par->defineSerotypeRelativeRisks();
+    par->betaPM = 0.5;
+    par->betaMP = 0.5;
+    par->fMosquitoMove = 0.15;
+    par->mosquitoMoveModel = "weighted";
+    par->fMosquitoTeleport = 0.0;
+    par->nDefaultMosquitoCapacity = 65;
+    par->nDaysImmune = 730;
+    par->birthdayInterval = 1;
+    par->annualIntroductionsCoef = 1.0;
+    par->nDailyExposed = {vector<float>(NUM_OF_SEROTYPES, scale)};
+    par->loadDailyEIP(toy_dir + "/eip-toy.txt");
+    par->populationFilename = files.population;
+    par->immunityFilename = files.immunity;
+    par->locationFilename = files.locations;
+    par->networkFilename = files.network;
+    par->swapProbFilename = files.swap;
+    par->abcVerbose = true;                                          // keeps periodic output quiet
+    gsl_rng_set(RNG, par->randomseed);
+
+    const uint64_t load_start = now_ns();
+    BenchCommunity* community = new BenchCommunity(par);
+    Person::setPar(par);
+    if (not community->loadLocations(par->locationFilename, par->networkFilename)
+        or not community->loadPopulation(par->populationFilename, par->immunityFilename, par->swapProbFilename)) {
+        cerr << "ERROR: Could not load population" << endl;
+        exit(-1);
+    }
+    const double load_seconds = (now_ns() - load_start) / 1e9;
+
+    using namespace dengue::instrument;
+    map<string, Kernel> kernels;
+    kernels["mosquito_to_human"].item = "infectious mosquitoes";
+    kernels["human_to_mosquito"].item = "hot locations";
+    kernels["timers"].item = "live mosquitoes";
+    kernels["movement"].item = "live mosquitoes";
+
+    // daily kernels: the phases of tick(), during an epidemic
+    Date date(par);
+    int nextMosquitoMultiplierIndex = 0;
+    int nextEIPindex = 0;
+    initialize_seasonality(par, community, nextMosquitoMultiplierIndex, nextEIPindex, date);
+    Kernel warmup;
+    for (; date.day() < par->nRunLength; date.increment()) {
+        update_mosquito_population(par, community, date, nextMosquitoMultiplierIndex);
+        update_extrinsic_incubation_period(par, community, date, nextEIPindex);
+        const uint64_t infectious = community->getNumInfectiousMosquitoes();
+        const uint64_t live = community->getNumLiveMosquitoes();
+        tally().clear();
+        const bool warming_up = date.day() < warmup_days;
+        time_op(warming_up ? warmup : kernels["tick"], 0, [&]() { community->tick(date); });
+        seed_epidemic(par, community, date);
+        if (warming_up) continue;
+        const Tally &t = tally();
+        for (int phase = 0; phase < NUM_OF_PHASES; ++phase) {
+            if (t.ns[phase] == 0) continue;                           // gated off, or not part of tick()
+            Kernel &k = kernels[PHASE_NAMES[phase]];
+            k.ns += t.ns[phase];
+            ++k.ops;
+        }
+        kernels["mosquito_to_human"].items += infectious;
+        kernels["human_to_mosquito"].items += t.counts[HOT_LOCATIONS];
+        kernels["timers"].items += live;
+        kernels["movement"].items += live;
+    }
+
+    // isolated kernels
+    gsl_rng_set(RNG, par->randomseed);
+    vector<double> draws(reps);
+    for (double &u: draws) u = gsl_rng_uniform(RNG);
+    volatile int sink = 0;
+    time_op(kernels["sampler"], 0, [&]() {
+        for (double u: draws) sink += Parameters::sampler(MOSQUITO_DEATHAGE_CDF, u);
+    });
+    kernels["sampler"].ops = reps;
+
+    const vector<Location*> &locations = community->getLocations();
+    vector<Mosquito*> constructed(min(reps, 1000000));
+    vector<Location*> where(constructed.size());
+    for (Location* &loc: where) loc = locations[gsl_rng_uniform_int(RNG, locations.size())];
+    time_op(kernels["mosquito_construction"], 0, [&]() {
+        for (unsigned int i = 0; i < constructed.size(); ++i) {
+            constructed[i] = new Mosquito(where[i], (Serotype) (i % NUM_OF_SEROTYPES), where[i]->getID(), 10, (i % 100) / 100.0);
+        }
+    });
+    kernels["mosquito_construction"].ops = constructed.size();
+    for (Mosquito* m: constructed) delete m;
+
+    vector<Mosquito*> mosquitoes = community->liveMosquitoes();
+    if (mosquitoes.size() > 0) {
+        par->fMosquitoMove = 1.0;                                     // every call moves the mosquito
+        const int rounds = max(1, reps / (int) mosquitoes.size());
+        for (const string model: {"weighted", "uniform"}) {
+            par->mosquitoMoveModel = model;
+            community->parametersChanged();                           // moveMosquito() is specialized on the model
+            Kernel &k = kernels["move_mosquito_" + model];
+            time_op(k, 0, [&]() {
+                for (int r = 0; r < rounds; ++r) for (Mosquito* m: mosquitoes) community->moveMosquito(m);
+            });
+            k.ops = rounds * mosquitoes.size();
+        }
+    } else {
+        cerr << "WARNING: no live mosquitoes at the end of the epidemic; move_mosquito not timed" << endl;
+    }
+
+    FILE* fh = out_filename == "" ? stdout : fopen(out_filename.c_str(), "w");
+    if (not fh) {
+        cerr << "ERROR: Could not open benchmark output file: " << out_filename << endl;
+        exit(-1);
+    }
+    write_json(fh, par, community, kernels, load_seconds, scale);
+    if (fh != stdout) fclose(fh);
+    return 0;
+}
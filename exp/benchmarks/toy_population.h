@@ -0,0 +1,153 @@
+// toy_population.h
+// Builds a loadable population from pop-toy, optionally tiled to any multiple of its size.
+//
+// pop-toy ships people, immunity and swap files in the old population format (pid hid age sex hh_serial pernum
+// workid, 1-based IDs) but no location or network file.  This renumbers people and locations from zero, writes
+// the people in the current format, places each copy of the town on its own unit square (planar coordinates,
+// copy c at x offset c), and links every location to its nearest neighbors within the copy.  A day location
+// that is mostly visited by people under 18 becomes a school; otherwise it is a workplace.
+#ifndef __TOY_POPULATION_H
+#define __TOY_POPULATION_H
+
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <map>
+#include <string>
+#include <vector>
+#include <gsl/gsl_rng.h>
+#include "Location.h"
+#include "SpatialIndex.h"
+
+struct PopulationFiles {
+    std::string population;
+    std::string immunity;
+    std::string locations;
+    std::string network;
+    std::string swap;
+};
+
+namespace toy_population {
+    struct ToyPerson { int hid, age, sex, workid; };
+
+    inline std::vector<std::vector<std::string> > _read_table(const std::string filename) {
+        std::ifstream in(filename.c_str());
+        if (not in) {
+            std::cerr << "ERROR: " << filename << " not found." << std::endl;
+            exit(-1);
+        }
+        std::vector<std::vector<std::string> > rows;
+        std::string buffer;
+        getline(in, buffer);                                          // header
+        while (getline(in, buffer)) {
+            std::istringstream line(buffer);
+            std::vector<std::string> fields;
+            std::string field;
+            while (line >> field) fields.push_back(field);
+            if (fields.size() > 0) rows.push_back(fields);
+        }
+        return rows;
+    }
+
+    // Writes files for `copies` copies of the toy town to directory out_dir and returns their names
+    inline PopulationFiles build(const std::string toy_dir, const std::string out_dir, int copies, unsigned long int seed, unsigned int degree = 8) {
+        const std::vector<std::vector<std::string> > people_rows = _read_table(toy_dir + "/population-toy.txt");
+        const std::vector<std::vector<std::string> > immunity_rows = _read_table(toy_dir + "/immunity-toy.txt");
+        const std::vector<std::vector<std::string> > swap_rows = _read_table(toy_dir + "/swap_probabilities-toy.txt");
+
+        // toy IDs -> zero-based location IDs within one copy; homes first, then day locations
+        std::vector<ToyPerson> people;
+        std::map<int, int> home_index, day_index;
+        for (const auto &r: people_rows) {
+            ToyPerson p = {atoi(r[1].c_str()), atoi(r[2].c_str()), atoi(r[3].c_str()), atoi(r[6].c_str())};
+            people.push_back(p);
+            if (home_index.count(p.hid) == 0) home_index[p.hid] = 0;
+        }
+        for (const ToyPerson &p: people) {
+            if (p.workid != p.hid and home_index.count(p.workid) == 0 and day_index.count(p.workid) == 0) day_index[p.workid] = 0;
+        }
+        int n = 0;
+        for (auto &h: home_index) h.second = n++;
+        std::vector<int> minors(day_index.size(), 0), visitors(day_index.size(), 0);
+        for (auto &d: day_index) d.second = n++;
+        for (const ToyPerson &p: people) {
+            auto it = day_index.find(p.workid);
+            if (it == day_index.end()) continue;
+            ++visitors[it->second - home_index.size()];
+            minors[it->second - home_index.size()] += p.age < 18;
+        }
+        const int num_locations = n;
+        const int num_people = people.size();
+
+        // pop-toy's swap file misses a few people; they take their immunity from someone a year younger
+        std::vector<bool> has_swap(num_people, false);
+        for (const auto &r: swap_rows) has_swap[atoi(r[0].c_str()) - 1] = true;
+        std::map<int, int> someone_aged;
+        for (int i = 0; i < num_people; ++i) someone_aged[people[i].age] = i;
+
+        PopulationFiles files = {out_dir + "/population.txt", out_dir + "/immunity.txt", out_dir + "/locations.txt",
+                                 out_dir + "/network.txt", out_dir + "/swap_probabilities.txt"};
+        std::ofstream pop(files.population.c_str()), imm(files.immunity.c_str()), loc(files.locations.c_str()),
+                      net(files.network.c_str()), swp(files.swap.c_str());
+        if (not (pop and imm and loc and net and swp)) {
+            std::cerr << "ERROR: Could not write population files to " << out_dir << std::endl;
+            exit(-1);
+        }
+        pop << "pid hid sex age did\n";
+        imm << "pid age imm1 imm2 imm3 imm4\n";
+        loc << "id x y type arm surveilled\n" << std::setprecision(12);
+        net << "locid1 locid2\n";
+
+        gsl_rng* rng = gsl_rng_alloc(gsl_rng_taus2);
+        gsl_rng_set(rng, seed);
+        for (int c = 0; c < copies; ++c) {
+            const int pid_offset = c * num_people;
+            const int loc_offset = c * num_locations;
+            for (int i = 0; i < num_people; ++i) {
+                const ToyPerson &p = people[i];
+                const int home = home_index[p.hid] + loc_offset;
+                const auto day = day_index.find(p.workid);
+                pop << i + pid_offset << " " << home << " " << p.sex << " " << p.age << " "
+                    << (day == day_index.end() ? -1 : day->second + loc_offset) << "\n";
+            }
+            for (const auto &r: immunity_rows) {
+                imm << atoi(r[0].c_str()) - 1 + pid_offset;
+                for (unsigned int f = 1; f < r.size(); ++f) imm << " " << r[f];
+                imm << "\n";
+            }
+            for (const auto &r: swap_rows) {
+                swp << atoi(r[0].c_str()) - 1 + pid_offset << " " << atoi(r[1].c_str()) - 1 + pid_offset << " " << r[2] << "\n";
+            }
+            for (int i = 0; i < num_people; ++i) {
+                const auto donor = someone_aged.find(people[i].age - 1);
+                if (not has_swap[i] and donor != someone_aged.end()) swp << i + pid_offset << " " << donor->second + pid_offset << " 1\n";
+            }
+
+            std::vector<Location*> copy_locations(num_locations);
+            for (int l = 0; l < num_locations; ++l) {
+                const int d = l - (int) home_index.size();
+                const char type = d < 0 ? 'h' : 2 * minors[d] > visitors[d] ? 's' : 'w';
+                const double x = c + gsl_rng_uniform(rng);
+                const double y = gsl_rng_uniform(rng);
+                loc << l + loc_offset << " " << x << " " << y << " " << type << " 0 0\n";
+                copy_locations[l] = new Location();
+                copy_locations[l]->setID(l);
+                copy_locations[l]->setX(x);
+                copy_locations[l]->setY(y);
+            }
+            SpatialIndex index;
+            index.build(copy_locations, false);
+            for (const Location* a: copy_locations) {
+                for (const Location* b: index.nearest(a->getX(), a->getY(), degree + 1)) {
+                    if (a != b) net << a->getID() + loc_offset << " " << b->getID() + loc_offset << "\n"; // duplicates are ignored on load
+                }
+            }
+            for (Location* l: copy_locations) delete l;
+        }
+        gsl_rng_free(rng);
+        return files;
+    }
+}
+#endif
@@ -1,6 +1,7 @@
 #include <unistd.h>
 #include "AbcSmc.h"
 #include "simulator.h"
+#include "Metrics.h"
 #include <cstdlib>
 #include "CCRC32.h"
 #include "Utility.h"
@@ -196,62 +197,17 @@ void append_if_finite(vector<double> &vec, double val) {
 }
 
 
-vector<double> tally_counts(const Parameters* par, Community* community, int pre_intervention_output) {
+// Cases by epidemic year, starting pre_intervention_output years before the interventions, counted as they occur;
+// register it with the community before the run
+EpidemicYearCases case_tally(const Parameters* par, int pre_intervention_output) {
     // aggregate based on the timing of the annual start of vector control
     int discard_days = INT_MAX;
     for (VectorControlEvent vce: par->vectorControlEvents) {
         discard_days = discard_days < vce.campaignStart ? discard_days : vce.campaignStart;
     }
     discard_days = discard_days==INT_MAX ? 365*(RESTART_BURNIN-pre_intervention_output) : discard_days - (365*pre_intervention_output);
-
-    //vector< vector<int> > severe      = community->getNumSevereCases();
-    vector< vector<int> > symptomatic = community->getNumNewlySymptomatic();
-
-    //vector< vector<int> > infected    = community->getNumNewlyInfected();
     const int num_years = FORECAST_DURATION + pre_intervention_output - 1; // typically 55
-    vector<vector<int> > s_tally(NUM_OF_SEROTYPES, vector<int>(num_years+1, 0));
-
-    vector<double> metrics(num_years, 0.0);
-    for (int t=discard_days; t<par->nRunLength; t++) {
-        // use epidemic years, instead of calendar years
-        const int y = (t-discard_days)/365;
-        for (int s=0; s<NUM_OF_SEROTYPES; s++) {
-            s_tally[s][y] += symptomatic[s][t];
-        }
-        //cout << "d,i:" << t << "," << infected[0][t] + infected[1][t] + infected[2][t] + infected[3][t] << endl;
-    }
-    for (int s=0; s<NUM_OF_SEROTYPES; s++) {
-        for (int y = 0; y<num_years; ++y) {
-            metrics[y] += s_tally[s][y];
-        }
-    }
-
-/*
-    vector<int> pop_sizes  = vector<int>(10,0);
-    vector<double> seropos = vector<double>(10,0.0); // seronegative at vaccination time
-
-    for (int i=community->getNumPerson()-1; i>=0; i--) {
-        Person *p = community->getPerson(i);
-        const int final_age  = p->getAge();
-        const int age_at_vac_start = RUN_FORECAST ? final_age - FORECAST_DURATION : final_age;
-        if (age_at_vac_start >= 9 and age_at_vac_start <= 18) {
-            int age_class = age_at_vac_start - 9;
-
-            const int serosurvey_day = (RESTART_BURNIN - age_class)*365;
-            const bool ever_infected = p->getNumNaturalInfections() > 0 ? true : false;
-            const bool isSeropos = ever_infected and p->getInfectionHistory().front()->getInfectedTime() < serosurvey_day;
-            ++pop_sizes[age_class];
-            if (isSeropos) ++seropos[age_class];
-        }
-    }
-    double seroprev_mean = 0.0;
-    for (unsigned int i = 0; i < seropos.size(); ++i) seroprev_mean += seropos[i] / pop_sizes[i];
-    assert(seropos.size() > 0);
-    seroprev_mean /= seropos.size();
-
-    metrics.push_back(seroprev_mean);
-*/
-    return metrics;
+    return EpidemicYearCases(EpidemicYearCases::CASES, discard_days, num_years);
 }
 
 vector<double> simulator(vector<double> args, const unsigned long int rng_seed, const unsigned long int serial, const ABC::MPI_par* mp) {
@@ -321,6 +277,10 @@ vector<double> simulator(vector<double> args, const unsigned long int rng_seed,
         }
     }
 
+    const int pre_intervention_output = 5; // years
+    EpidemicYearCases cases = case_tally(par, pre_intervention_output);
+    community->addObserver(&cases);
+
     seed_epidemic(par, community);
     //simulate_epidemic(par, community, process_id);
     vector< vector<double> > sero_prev;
@@ -331,9 +291,8 @@ vector<double> simulator(vector<double> args, const unsigned long int rng_seed,
     time (&end);
     double dif = difftime (end,start);
 
-    const int pre_intervention_output = 5; // years
     const int desired_intervention_output = FORECAST_DURATION - 1;
-    vector<double> metrics = tally_counts(par, community, pre_intervention_output);
+    vector<double> metrics(cases.counts().begin(), cases.counts().end());
 
     assert(sero_prev.size() == 5);
     for (unsigned int i = 1; i < sero_prev.size(); ++i) assert(sero_prev[0].size() == sero_prev[i].size());
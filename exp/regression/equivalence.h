@@ -0,0 +1,127 @@
+// equivalence.h
+// Two-sample tests for whether a candidate build's per-seed outputs come from the same distribution as the
+// reference build's: Kolmogorov-Smirnov, and the Anderson-Darling k-sample test of Scholz & Stephens (1987, JASA
+// 82:918), in its version for samples with ties (simulation outputs are counts, so ties are common).
+#ifndef __EQUIVALENCE_H
+#define __EQUIVALENCE_H
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace equivalence {
+    struct TestResult {
+        double statistic;
+        double p_value;
+    };
+
+    // Two-sided; p from the asymptotic Kolmogorov distribution with Stephens' small-sample correction
+    inline TestResult ks_test(std::vector<double> a, std::vector<double> b) {
+        std::sort(a.begin(), a.end());
+        std::sort(b.begin(), b.end());
+        const double n = a.size(), m = b.size();
+        unsigned int i = 0, j = 0;
+        double d = 0.0;
+        while (i < a.size() and j < b.size()) {
+            const double x = std::min(a[i], b[j]);
+            while (i < a.size() and a[i] == x) ++i;
+            while (j < b.size() and b[j] == x) ++j;
+            d = std::max(d, std::fabs(i / n - j / m));
+        }
+        const double ne = sqrt(n * m / (n + m));
+        const double lambda = (ne + 0.12 + 0.11 / ne) * d;
+        double p = 0.0;
+        for (int k = 1; k <= 100; ++k) {
+            const double term = 2.0 * (k % 2 ? 1 : -1) * exp(-2.0 * k * k * lambda * lambda);
+            p += term;
+            if (std::fabs(term) < 1e-12) break;
+        }
+        TestResult r = {d, lambda < 1e-3 ? 1.0 : std::min(1.0, std::max(0.0, p))};
+        return r;
+    }
+
+    // Standardized statistic T_akN; p interpolated from the critical values of Scholz & Stephens (as scipy's
+    // anderson_ksamp does), so p values far outside [0.001, 0.25] are extrapolations
+    inline TestResult ad_test(const std::vector<double> &a, const std::vector<double> &b) {
+        const std::vector<std::vector<double> > samples = {a, b};
+        const int k = samples.size();
+        std::vector<double> pooled(a);
+        pooled.insert(pooled.end(), b.begin(), b.end());
+        std::sort(pooled.begin(), pooled.end());
+        const double N = pooled.size();
+
+        std::vector<double> distinct, multiplicity;
+        for (double v: pooled) {
+            if (distinct.size() and distinct.back() == v) ++multiplicity.back();
+            else { distinct.push_back(v); multiplicity.push_back(1); }
+        }
+        if (distinct.size() < 2) {                                   // all values equal: identical samples
+            TestResult r = {0.0, 1.0};
+            return r;
+        }
+
+        double A2 = 0.0;
+        for (const auto &sample: samples) {
+            std::vector<double> sorted(sample);
+            std::sort(sorted.begin(), sorted.end());
+            const double n = sorted.size();
+            double inner = 0.0, B = 0.0, M = 0.0;
+            unsigned int s = 0;
+            for (unsigned int j = 0; j < distinct.size(); ++j) {
+                double f = 0;
+                while (s < sorted.size() and sorted[s] == distinct[j]) { ++f; ++s; }
+                const double l = multiplicity[j];
+                B += l;
+                M += f;
+                const double Ba = B - l / 2.0;
+                const double Ma = M - f / 2.0;
+                const double denom = Ba * (N - Ba) - N * l / 4.0;
+                if (denom > 0) inner += l / N * (N * Ma - n * Ba) * (N * Ma - n * Ba) / denom;
+            }
+            A2 += inner / n;
+        }
+        A2 *= (N - 1) / N;
+
+        double H = 0.0, h = 0.0, g = 0.0;
+        for (const auto &sample: samples) H += 1.0 / sample.size();
+        for (int i = 1; i < N; ++i) h += 1.0 / i;
+        for (int i = 1; i <= N - 2; ++i) for (int j = i + 1; j <= N - 1; ++j) g += 1.0 / ((N - i) * j);
+        const double a_ = (4*g - 6)*(k - 1) + (10 - 6*g)*H;
+        const double b_ = (2*g - 4)*k*k + 8*h*k + (2*g - 14*h - 4)*H - 8*h + 4*g - 6;
+        const double c_ = (6*h + 2*g - 2)*k*k + (4*h - 4*g + 6)*k + (2*h - 6)*H + 4*h;
+        const double d_ = (2*h + 6)*k*k - 4*h*k;
+        const double var = (a_*N*N*N + b_*N*N + c_*N + d_) / ((N - 1)*(N - 2)*(N - 3));
+        const double T = (A2 - (k - 1)) / sqrt(var);
+
+        // critical values for k - 1 = 1, and a quadratic fit of log(significance) against them
+        const double sig[7] = {0.25, 0.1, 0.05, 0.025, 0.01, 0.005, 0.001};
+        const double b0[7]  = {0.675, 1.281, 1.645, 1.960, 2.326, 2.573, 3.085};
+        const double b1[7]  = {-0.245, 0.250, 0.678, 1.149, 1.822, 2.364, 3.615};
+        const double b2[7]  = {-0.105, -0.305, -0.362, -0.391, -0.396, -0.345, -0.154};
+        double S[5] = {0, 0, 0, 0, 0}, Y[3] = {0, 0, 0};              // sums of x^0..x^4, and of x^0..x^2 * y
+        for (int i = 0; i < 7; ++i) {
+            const double x = b0[i] + b1[i] + b2[i];                   // / sqrt(k - 1), / (k - 1)
+            const double y = log(sig[i]);
+            double xp = 1.0;
+            for (int e = 0; e < 5; ++e) { S[e] += xp; if (e < 3) Y[e] += xp * y; xp *= x; }
+        }
+        // solve the 3x3 normal equations for y = c0 + c1 x + c2 x^2 (Cramer's rule)
+        const double m[3][3] = {{S[0], S[1], S[2]}, {S[1], S[2], S[3]}, {S[2], S[3], S[4]}};
+        auto det3 = [](const double q[3][3]) {
+            return q[0][0]*(q[1][1]*q[2][2] - q[1][2]*q[2][1]) - q[0][1]*(q[1][0]*q[2][2] - q[1][2]*q[2][0])
+                 + q[0][2]*(q[1][0]*q[2][1] - q[1][1]*q[2][0]);
+        };
+        const double D = det3(m);
+        double c[3];
+        for (int col = 0; col < 3; ++col) {
+            double q[3][3];
+            for (int r = 0; r < 3; ++r) for (int cc = 0; cc < 3; ++cc) q[r][cc] = cc == col ? Y[r] : m[r][cc];
+            c[col] = det3(q) / D;
+        }
+        double p = exp(c[0] + c[1]*T + c[2]*T*T);
+        if (T < b0[0] + b1[0] + b2[0]) p = std::max(p, sig[0]);       // the fit is not monotone below the table
+        TestResult r = {T, std::min(1.0, std::max(0.0, p))};
+        return r;
+    }
+}
+#endif
@@ -0,0 +1,488 @@
+// regression.cpp
+// Golden-output regression checks for the simulator, on pop-toy.
+//
+// A fixed set of scenarios (baseline, uniform mosquito movement, vaccination, IRS, delayed birthdays) is run from
+// a fixed seed, and everything that should not change under a pure performance change is recorded: per-day
+// incidence by serotype (infections, symptomatic and severe cases, cases in vaccinees), per-day infectious and
+// live mosquito counts, and a digest of every person's final immune state (infection and vaccination histories).
+//
+// Exact mode (the default) requires a build to reproduce the golden files bit for bit; use it for changes that
+// keep the RNG stream.  With -seeds n, each scenario is instead run from n seeds (in -jobs parallel processes) and
+// only per-seed outputs are recorded: annual incidence and epidemic peak day, seroprevalence by age, the serotype
+// mix, and totals.  A build passes if the distribution of every output matches the golden one by two-sample
+// Kolmogorov-Smirnov and Anderson-Darling tests at -alpha (family-wise, per scenario), and its mean is within -z
+// standard errors.  Use this for changes that legitimately alter the RNG stream; 40 or more seeds are advisable.
+//
+// Golden files depend on the GSL version, so record them with the reference build before making a change:
+//
+//   ./regression -record [-golden dir] [-seeds n]       (reference build)
+//   ./regression [-golden dir] [-seeds n] [-alpha 0.01] [-z 4]   (changed build; exits non-zero on any difference)
+//
+// Other options: [-scenario name]... [-days d] [-seed n] [-jobs n] [-verbose] [-toydir ../../pop-toy] [-workdir dir]
+#include <cstdio>
+#include <cstring>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "simulator.h"
+#include "toy_population.h"
+#include "equivalence.h"
+
+using namespace std;
+
+const unsigned long int POPULATION_SEED = 5500;                        // the toy town's layout does not vary with -seed
+
+struct Scenario {
+    string name;
+    void (*configure)(Parameters* par);
+};
+
+void configure_baseline(Parameters*) {}
+
+void configure_uniform_movement(Parameters* par) { par->mosquitoMoveModel = "uniform"; }
+
+void configure_vaccine(Parameters* par) {
+    par->vaccineTargetAge = 9;
+    par->vaccineTargetCoverage = 0.8;
+    par->vaccineTargetStartDate = 100;
+    par->bVaccineLeaky = true;
+    par->numVaccineDoses = 3;
+    par->vaccineDoseInterval = 182;
+    par->vaccineBoosting = true;
+    par->vaccineBoostingInterval = 365;
+    par->fVESs = vector<double>(NUM_OF_SEROTYPES, 0.7);
+    par->fVESs_NAIVE = par->fVESs;
+    for (int age = 10; age <= 30; ++age) par->catchupVaccinationEvents.emplace_back(age, 100, 0.5, 30);
+}
+
+void configure_irs(Parameters* par) {
+    for (int start = 100; start < par->nRunLength; start += 365) {
+        par->vectorControlEvents.emplace_back(start, 90, 0.2, 0.8, 90, HOME, UNIFORM_STRATEGY);
+    }
+}
+
+void configure_delayed_birthdays(Parameters* par) { par->delayBirthdayIfInfected = true; }
+
+const vector<Scenario> SCENARIOS = {
+    {"baseline",          configure_baseline},
+    {"uniform_movement",  configure_uniform_movement},
+    {"vaccine",           configure_vaccine},
+    {"irs",               configure_irs},
+    {"delayed_birthdays", configure_delayed_birthdays}
+};
+
+Parameters* define_parameters(const PopulationFiles &files, const string toy_dir, unsigned long int seed, int days) {
+    Parameters* par = new Parameters();
+    par->define_defaults();
+    par->randomseed = seed;
+    par->nRunLength = days;
+    par->startJulianYear = 2000;
+    par->simulateAnnualSerotypes = false;
+    par->reportedFraction = {0.0, 0.1, 0.5};
+    par->defineSerotypeRelativeRisks();
+    par->basePathogenicity = 0.3;
+    par->betaPM = 0.1;
+    par->betaMP = 0.25;
+    par->fMosquitoMove = 0.15;
+    par->mosquitoMoveModel = "weighted";
+    par->fMosquitoTeleport = 0.0;
+    par->nDefaultMosquitoCapacity = 60;
+    par->eMosquitoDistribution = EXPONENTIAL;
+    par->birthdayInterval = 1;
+    par->nDaysImmune = 730;
+    par->annualIntroductionsCoef = 1.0;
+    par->nDailyExposed = {{0.5, 0.5, 0.5, 0.5}};
+    par->abcVerbose = true;                                           // keeps periodic output quiet
+    par->geographicCoordinates = false;
+    par->loadDailyEIP(toy_dir + "/eip-toy.txt");
+    par->populationFilename = files.population;
+    par->immunityFilename = files.immunity;
+    par->locationFilename = files.locations;
+    par->networkFilename = files.network;
+    par->swapProbFilename = files.swap;
+    return par;
+}
+
+// 64-bit FNV-1a, fed one int at a time
+class Digest {
+    public:
+        Digest() : _h(14695981039346656037ULL) {}
+        void add(long int v) {
+            for (unsigned int i = 0; i < sizeof(v); ++i) { _h ^= (v >> (8*i)) & 0xff; _h *= 1099511628211ULL; }
+        }
+        string hex() const { char buf[17]; snprintf(buf, sizeof(buf), "%016llx", (unsigned long long) _h); return buf; }
+    private:
+        unsigned long long _h;
+};
+
+struct RunResult {
+    vector<string> daily;                                             // one line per day
+    string final_state;
+    vector< pair<string, double> > summary;                           // per-seed outputs, for statistical checks
+};
+
+const vector<int> AGE_CLASS_MAX = {4, 9, 14, 19, 29, 39, 49, 59, INT_MAX}; // as in simulate_abc()
+const vector<string> AGE_CLASS_NAMES = {"0_4", "5_9", "10_14", "15_19", "20_29", "30_39", "40_49", "50_59", "60_"};
+
+// Annual incidence and epidemic peak timing, the serotype mix, and final seroprevalence by age
+void summarize(Community* community, int days, const vector<double> &totals, RunResult &result) {
+    const vector< vector<int> > infected = community->getNumNewlyInfected();
+    const double people = community->getNumPeople();
+    const int years = max(1, days / 365);
+    const int year_length = days / years;
+    vector<double> by_serotype(NUM_OF_SEROTYPES, 0.0);
+    for (int y = 0; y < years; ++y) {
+        vector<int> daily(year_length, 0);
+        for (int d = 0; d < year_length; ++d) {
+            for (int s = 0; s < NUM_OF_SEROTYPES; ++s) {
+                daily[d] += infected[s][y*year_length + d];
+                by_serotype[s] += infected[s][y*year_length + d];
+            }
+        }
+        int total = 0, peak_day = -1, peak = 0;
+        for (int d = 0; d < year_length; ++d) {
+            total += daily[d];
+            int week = 0;                                             // centered 7-day window
+            for (int w = max(0, d - 3); w <= min(year_length - 1, d + 3); ++w) week += daily[w];
+            if (week > peak) { peak = week; peak_day = d; }
+        }
+        result.summary.emplace_back("incidence_y" + to_string(y), 1e3 * total / people);
+        result.summary.emplace_back("peak_day_y" + to_string(y), peak_day);
+    }
+    const double all_infections = accumulate(by_serotype.begin(), by_serotype.end(), 0.0);
+    for (int s = 0; s < NUM_OF_SEROTYPES; ++s) {
+        result.summary.emplace_back("serotype_" + to_string(s + 1), all_infections > 0 ? by_serotype[s] / all_infections : 0.0);
+    }
+
+    vector<double> seropositive(AGE_CLASS_MAX.size(), 0.0), size(AGE_CLASS_MAX.size(), 0.0);
+    for (const Person* p: community->getPeople()) {
+        unsigned int a = 0;
+        while (p->getAge() > AGE_CLASS_MAX[a]) ++a;
+        ++size[a];
+        seropositive[a] += p->getNumNaturalInfections() > 0;
+    }
+    for (unsigned int a = 0; a < AGE_CLASS_MAX.size(); ++a) {
+        result.summary.emplace_back("seroprev_" + AGE_CLASS_NAMES[a], size[a] > 0 ? seropositive[a] / size[a] : 0.0);
+    }
+
+    const vector<string> total_names = {"infections", "symptomatic", "severe", "vaccinated_cases", "seropositive", "vaccinated"};
+    for (unsigned int i = 0; i < total_names.size(); ++i) result.summary.emplace_back(total_names[i], totals[i]);
+}
+
+RunResult run(const Scenario &scenario, const PopulationFiles &files, const string toy_dir, unsigned long int seed, int days) {
+    Parameters* par = define_parameters(files, toy_dir, seed, days);
+    scenario.configure(par);
+    gsl_rng_set(RNG, seed);
+    Community* community = build_community(par);
+
+    // as in simulate_epidemic()
+    Date date(par);
+    int nextMosquitoMultiplierIndex = 0;
+    int nextEIPindex = 0;
+    initialize_seasonality(par, community, nextMosquitoMultiplierIndex, nextEIPindex, date);
+    schedule_vector_control(par, community);
+    map<string, vector<int> > periodic_incidence = construct_tally();
+    vector<int> periodic_prevalence(NUM_OF_PREVALENCE_REPORTING_TYPES, 0);
+    vector<int> proto_metrics;
+    vector<int> infectious_mosquitoes, live_mosquitoes;
+    for (; date.day() < par->nRunLength; date.increment()) {
+        update_vaccinations(par, community, date);
+        advance_simulator(par, community, date, scenario.name, periodic_incidence, periodic_prevalence, nextMosquitoMultiplierIndex, nextEIPindex, proto_metrics);
+        infectious_mosquitoes.push_back(community->getNumInfectiousMosquitoes());
+        live_mosquitoes.push_back(community->getNumLiveMosquitoes());
+    }
+
+    RunResult result;
+    vector<double> totals(6, 0.0);
+    const vector< vector<int> > tallies[] = {community->getNumNewlyInfected(), community->getNumNewlySymptomatic(),
+                                             community->getNumSevereCases(), community->getNumVaccinatedCases()};
+    for (int day = 0; day < days; ++day) {
+        ostringstream line;
+        line << day;
+        for (unsigned int t = 0; t < 4; ++t) {
+            for (int s = 0; s < NUM_OF_SEROTYPES; ++s) {
+                line << " " << tallies[t][s][day];
+                totals[t] += tallies[t][s][day];
+            }
+        }
+        line << " " << infectious_mosquitoes[day] << " " << live_mosquitoes[day];
+        result.daily.push_back(line.str());
+    }
+
+    Digest digest;
+    for (const Person* p: community->getPeople()) {
+        digest.add(p->getID());
+        digest.add(p->getAge());
+        digest.add(p->isDead());
+        for (const Infection* inf: p->getInfectionHistory()) {
+            digest.add(inf->serotype());
+            digest.add(inf->getInfectedTime());
+            digest.add(inf->getSymptomTime());
+            digest.add(inf->getRecoveryTime());
+            digest.add(inf->isSevere());
+        }
+        for (int t: p->getVaccinationHistory()) digest.add(t);
+        totals[4] += p->getNumNaturalInfections() > 0;
+        totals[5] += p->isVaccinated();
+    }
+    ostringstream final_state;
+    final_state << "final_state " << digest.hex() << " people " << community->getNumPeople()
+                << " seropositive " << totals[4] << " vaccinated " << totals[5];
+    result.final_state = final_state.str();
+    summarize(community, days, totals, result);
+
+    delete community;
+    delete par;
+    return result;
+}
+
+string golden_filename(const string dir, const string scenario, int num_seeds) {
+    return dir + "/" + scenario + (num_seeds > 0 ? "-seeds.txt" : ".txt");
+}
+
+// Statistical checks may use other seeds (and more or fewer of them) than the golden run
+string header(const string scenario, unsigned long int seed, int days, int num_seeds) {
+    ostringstream ss;
+    ss << "# scenario " << scenario << " days " << days;
+    if (num_seeds == 0) ss << " seed " << seed;
+    return ss.str();
+}
+
+vector<string> read_lines(const string filename) {
+    ifstream in(filename.c_str());
+    if (not in) {
+        cerr << "ERROR: Golden file not found: " << filename << " (record it with -record)" << endl;
+        exit(-1);
+    }
+    vector<string> lines;
+    string buffer;
+    while (getline(in, buffer)) lines.push_back(buffer);
+    return lines;
+}
+
+void write_lines(const string filename, const vector<string> &lines) {
+    ofstream out(filename.c_str());
+    if (not out) {
+        cerr << "ERROR: Could not open golden file for output: " << filename << endl;
+        exit(-1);
+    }
+    for (const string &l: lines) out << l << "\n";
+}
+
+// Exact mode: the first difference, if any, is reported
+bool check_exact(const vector<string> &golden, const vector<string> &current, const string scenario) {
+    for (unsigned int i = 0; i < max(golden.size(), current.size()); ++i) {
+        const string g = i < golden.size() ? golden[i] : "<missing>";
+        const string c = i < current.size() ? current[i] : "<missing>";
+        if (g != c) {
+            cerr << "FAIL " << scenario << ": line " << i + 1 << " differs\n  golden:  " << g << "\n  current: " << c << endl;
+            return false;
+        }
+    }
+    cerr << "PASS " << scenario << endl;
+    return true;
+}
+
+struct SeedTable {
+    vector<string> names;
+    vector< vector<double> > rows;                                    // [seed][column]
+    vector<double> column(unsigned int c) const { vector<double> v; for (const auto &r: rows) v.push_back(r[c]); return v; }
+};
+
+SeedTable parse_seed_table(const vector<string> &lines) {
+    SeedTable table;
+    for (const string &l: lines) {
+        istringstream ss(l);
+        string first;
+        if (not (ss >> first)) continue;
+        if (first == "#") {
+            string word;
+            if (ss >> word and word == "seed") while (ss >> word) table.names.push_back(word);
+            continue;
+        }
+        vector<double> row;
+        double v;
+        while (ss >> v) row.push_back(v);                             // after the seed
+        table.rows.push_back(row);
+    }
+    return table;
+}
+
+// Statistical mode: every per-seed output must pass two-sample KS and Anderson-Darling tests at alpha, Bonferroni
+// corrected for the number of outputs, and its mean must be within z_max standard errors of the golden mean
+bool check_statistical(const vector<string> &golden, const vector<string> &current, const string scenario, double alpha, double z_max, bool verbose) {
+    if (golden.size() == 0 or current.size() == 0 or golden[0] != current[0]) {
+        cerr << "FAIL " << scenario << ": golden file was recorded with different settings\n  golden:  "
+             << (golden.size() ? golden[0] : "") << "\n  current: " << (current.size() ? current[0] : "") << endl;
+        return false;
+    }
+    const SeedTable g = parse_seed_table(golden), c = parse_seed_table(current);
+    if (g.names != c.names) {
+        cerr << "FAIL " << scenario << ": golden file has different outputs (recorded by another version?)" << endl;
+        return false;
+    }
+    const double test_alpha = alpha / g.names.size();
+    bool pass = true;
+    for (unsigned int i = 0; i < g.names.size(); ++i) {
+        const vector<double> gv = g.column(i), cv = c.column(i);
+        const double g_mean = accumulate(gv.begin(), gv.end(), 0.0) / gv.size();
+        const double c_mean = accumulate(cv.begin(), cv.end(), 0.0) / cv.size();
+        double g_var = 0.0, c_var = 0.0;
+        for (double v: gv) g_var += (v - g_mean) * (v - g_mean) / (gv.size() - 1);
+        for (double v: cv) c_var += (v - c_mean) * (v - c_mean) / (cv.size() - 1);
+        const double se = sqrt(g_var / gv.size() + c_var / cv.size());
+        const double z = se > 0 ? (c_mean - g_mean) / se : (c_mean == g_mean ? 0.0 : INFINITY);
+        const equivalence::TestResult ks = equivalence::ks_test(gv, cv);
+        const equivalence::TestResult ad = equivalence::ad_test(gv, cv);
+        const bool ok = ks.p_value >= test_alpha and ad.p_value >= test_alpha and fabs(z) <= z_max;
+        if (not ok or verbose) {
+            fprintf(stderr, "%s %s: %-18s mean %10.4g vs golden %10.4g  z %7.2f  KS D %.3f p %.2g  AD T %6.2f p %.2g\n",
+                    ok ? "  ok" : "FAIL", scenario.c_str(), g.names[i].c_str(), c_mean, g_mean, z, ks.statistic, ks.p_value, ad.statistic, ad.p_value);
+        }
+        pass = pass and ok;
+    }
+    cerr << (pass ? "PASS " : "FAIL ") << scenario << " (" << g.rows.size() << " golden and " << c.rows.size() << " current seeds, "
+         << g.names.size() << " outputs, per-test alpha " << test_alpha << ")" << endl;
+    return pass;
+}
+
+// "seed value value ...", preceded by a "# seed name name ..." line if names is true
+string seed_lines(const Scenario &scenario, const PopulationFiles &files, const string toy_dir, unsigned long int seed, int days, bool names) {
+    const RunResult result = run(scenario, files, toy_dir, seed, days);
+    ostringstream lines;
+    if (names) {
+        lines << "# seed";
+        for (const auto &s: result.summary) lines << " " << s.first;
+        lines << "\n";
+    }
+    lines << seed;
+    for (const auto &s: result.summary) lines << " " << s.second;
+    return lines.str();
+}
+
+// Runs the seeds in `jobs` forked processes (the model's RNG and person IDs are global, so runs cannot share a
+// process); each worker writes its lines to a file in work_dir
+vector<string> run_seeds(const Scenario &scenario, const PopulationFiles &files, const string toy_dir, unsigned long int seed,
+                         int num_seeds, int days, int jobs, const string work_dir) {
+    vector<string> lines(num_seeds);
+    jobs = max(1, min(jobs, num_seeds));
+    if (jobs == 1) {
+        for (int k = 0; k < num_seeds; ++k) lines[k] = seed_lines(scenario, files, toy_dir, seed + k, days, k == 0);
+        return lines;
+    }
+    cout.flush();
+    cerr.flush();
+    vector<pid_t> workers;
+    for (int w = 0; w < jobs; ++w) {
+        const pid_t pid = fork();
+        if (pid < 0) {
+            cerr << "ERROR: Could not start worker process" << endl;
+            exit(-1);
+        } else if (pid == 0) {
+            ofstream out((work_dir + "/seeds." + to_string(w)).c_str());
+            for (int k = w; k < num_seeds; k += jobs) out << seed_lines(scenario, files, toy_dir, seed + k, days, k == 0) << "\n";
+            out.close();
+            _exit(out ? 0 : 1);
+        }
+        workers.push_back(pid);
+    }
+    for (int w = 0; w < jobs; ++w) {
+        int status;
+        if (waitpid(workers[w], &status, 0) < 0 or not WIFEXITED(status) or WEXITSTATUS(status) != 0) {
+            cerr << "ERROR: Worker process " << w << " failed" << endl;
+            exit(-1);
+        }
+        const string filename = work_dir + "/seeds." + to_string(w);
+        vector<string> worker_lines = read_lines(filename);
+        remove(filename.c_str());
+        if (w == 0 and worker_lines.size()) {                          // names, then seed 0
+            worker_lines[1] = worker_lines[0] + "\n" + worker_lines[1];
+            worker_lines.erase(worker_lines.begin());
+        }
+        for (unsigned int i = 0; i < worker_lines.size(); ++i) lines[w + i*jobs] = worker_lines[i];
+    }
+    return lines;
+}
+
+void usage_error(const string msg) {
+    cerr << "ERROR: " << msg << endl;
+    cerr << "Usage: ./regression [-record] [-golden dir] [-scenario name]... [-days d] [-seed n]" << endl;
+    cerr << "                    [-seeds n [-jobs n] [-alpha a] [-z max] [-verbose]] [-toydir dir] [-workdir dir]" << endl;
+    exit(-1);
+}
+
+int main(int argc, char* argv[]) {
+    bool record = false;
+    string golden_dir = "golden";
+    string toy_dir = "../../pop-toy";
+    string work_dir = "regression_population";
+    vector<string> selected;
+    int days = 730;
+    int num_seeds = 0;                                                // 0: exact mode
+    int jobs = sysconf(_SC_NPROCESSORS_ONLN);
+    double alpha = 0.01;
+    double z_max = 4.0;
+    bool verbose = false;
+    unsigned long int seed = 5500;
+
+    for (int i = 1; i < argc; ++i) {
+        const string opt = argv[i];
+        if (opt == "-record") { record = true; continue; }
+        if (opt == "-verbose") { verbose = true; continue; }
+        if (i + 1 >= argc) usage_error("missing value for " + opt);
+        const char* val = argv[++i];
+        if      (opt == "-golden")   golden_dir = val;
+        else if (opt == "-scenario") selected.push_back(val);
+        else if (opt == "-days")     days = atoi(val);
+        else if (opt == "-seed")     seed = strtoul(val, nullptr, 10);
+        else if (opt == "-seeds")    num_seeds = atoi(val);
+        else if (opt == "-jobs")     jobs = atoi(val);
+        else if (opt == "-alpha")    alpha = atof(val);
+        else if (opt == "-z")        z_max = atof(val);
+        else if (opt == "-toydir")   toy_dir = val;
+        else if (opt == "-workdir")  work_dir = val;
+        else usage_error("unknown option " + opt);
+    }
+    if (days < 1 or num_seeds < 0 or num_seeds == 1) usage_error("-days must be positive and -seeds at least 2");
+
+    vector<Scenario> scenarios = selected.size() ? vector<Scenario>() : SCENARIOS;
+    for (const string &name: selected) {
+        auto it = find_if(SCENARIOS.begin(), SCENARIOS.end(), [&](const Scenario &s) { return s.name == name; });
+        if (it == SCENARIOS.end()) usage_error("unknown scenario " + name);
+        scenarios.push_back(*it);
+    }
+
+    mkdir(work_dir.c_str(), 0755);
+    const PopulationFiles files = toy_population::build(toy_dir, work_dir, 1, POPULATION_SEED);
+    if (record) mkdir(golden_dir.c_str(), 0755);
+
+    int failures = 0;
+    for (const Scenario &scenario: scenarios) {
+        vector<string> lines = {header(scenario.name, seed, days, num_seeds)};
+        if (num_seeds == 0) {
+            RunResult result = run(scenario, files, toy_dir, seed, days);
+            lines.push_back("# day infected[4] symptomatic[4] severe[4] vaccinated_cases[4] infectious_mosquitoes live_mosquitoes");
+            lines.insert(lines.end(), result.daily.begin(), result.daily.end());
+            lines.push_back(result.final_state);
+        } else {
+            for (const string &l: run_seeds(scenario, files, toy_dir, seed, num_seeds, days, jobs, work_dir)) {
+                istringstream ss(l);
+                string line;
+                while (getline(ss, line)) lines.push_back(line);
+            }
+        }
+
+        const string filename = golden_filename(golden_dir, scenario.name, num_seeds);
+        if (record) {
+            write_lines(filename, lines);
+            cerr << "recorded " << filename << endl;
+        } else {
+            const vector<string> golden = read_lines(filename);
+            const bool pass = num_seeds == 0 ? check_exact(golden, lines, scenario.name)
+                                             : check_statistical(golden, lines, scenario.name, alpha, z_max, verbose);
+            failures += not pass;
+        }
+    }
+    if (failures > 0) cerr << failures << " of " << scenarios.size() << " scenarios failed" << endl;
+    return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,81 @@
+// make_forcing: builds a forcing file for -forcingfile (Forcing.h) from text tables
+//
+// usage: make_forcing <forcing file> [-eip table] [-capacity table]
+//
+// Each table has one row per day, starting on January 1, and one whitespace-separated column per region; lines
+// that do not start with a number (e.g. a header) are skipped.  Given both, the tables must be the same shape.
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "Forcing.h"
+
+using namespace std;
+
+void usage() {
+    cerr << "usage: make_forcing <forcing file> [-eip table] [-capacity table]" << endl;
+    exit(-1);
+}
+
+// Reads filename into values (row-major); sets num_regions and num_days
+void read_table(const string filename, vector<float>& values, uint32_t& num_regions, uint32_t& num_days) {
+    ifstream iss(filename.c_str());
+    if (!iss) {
+        cerr << "ERROR: " << filename << " not found." << endl;
+        exit(-1);
+    }
+    num_regions = num_days = 0;
+    string buffer;
+    while (getline(iss, buffer)) {
+        istringstream line(buffer);
+        vector<float> row;
+        float value;
+        while (line >> value) row.push_back(value);
+        if (row.empty()) continue;
+        if (num_days > 0 and row.size() != num_regions) {
+            cerr << "ERROR: " << filename << ": expected " << num_regions << " regions on day " << num_days << ", found " << row.size() << endl;
+            exit(-1);
+        }
+        num_regions = row.size();
+        values.insert(values.end(), row.begin(), row.end());
+        ++num_days;
+    }
+    if (num_days == 0) {
+        cerr << "ERROR: " << filename << " has no data" << endl;
+        exit(-1);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 4 or argc % 2 != 0) usage();
+    const string filename = argv[1];
+    vector<float> eip, capacity;
+    uint32_t num_regions = 0, num_days = 0;
+    for (int i = 2; i < argc; i += 2) {
+        vector<float>* table = nullptr;
+        if (strcmp(argv[i], "-eip") == 0) {
+            table = &eip;
+        } else if (strcmp(argv[i], "-capacity") == 0) {
+            table = &capacity;
+        } else {
+            usage();
+        }
+        uint32_t regions, days;
+        read_table(argv[i+1], *table, regions, days);
+        if (num_days > 0 and (regions != num_regions or days != num_days)) {
+            cerr << "ERROR: " << argv[i+1] << " is " << days << " days by " << regions << " regions; expected "
+                 << num_days << " by " << num_regions << endl;
+            exit(-1);
+        }
+        num_regions = regions;
+        num_days = days;
+    }
+    Forcing::write(filename, num_regions, num_days, eip, capacity);
+    Forcing check(filename, 0);                                       // validates values
+    cerr << filename << ": " << num_days << " days, " << num_regions << " regions" << (check.has(Forcing::EIP) ? ", EIP" : "")
+         << (check.has(Forcing::CAPACITY) ? ", capacity" : "") << endl;
+    return 0;
+}
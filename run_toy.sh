@@ -1,5 +1,6 @@
 #valgrind --tool=callgrind ./model -randomseed $SEED \
 SEED=5500
+# periodic (daily) output goes to ./toy-output/daily-output-toy-multiseason-randomseed$SEED.csv.<process id>
 ./model -randomseed $SEED \
         -locfile ./pop-toy/locations-toy.txt \
         -netfile ./pop-toy/network-toy.txt \
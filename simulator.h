@@ -1,10 +1,14 @@
 #include <cstdlib>
 #include <cstring>
 #include <climits>
+#include <cstdint>
 #include <iostream>
 #include <fstream>
 #include <string>
 #include <sstream>
+#include <functional>
+#include <limits>
+#include <memory>
 #include <assert.h>
 #include <gsl/gsl_rng.h>
 #include <gsl/gsl_randist.h>
@@ -16,6 +20,12 @@
 #include "Utility.h"
 #include "sys/stat.h"
 #include "Date.h"
+#include "Instrumentation.h"
+#include "Output.h"
+#include "InfectionLog.h"
+#include "TransmissionChain.h"
+#include "IncidenceRaster.h"
+#include "Forcing.h"
 
 using namespace dengue::standard;
 using namespace dengue::util;
@@ -102,6 +112,43 @@ enum PrevalenceReportingType {
 
 const gsl_rng* RNG = gsl_rng_alloc (gsl_rng_taus2);
 
+// One simulated day of periodic output, as written with -binarydailyoutput: the same numbers as a text "day:"
+// line, in native byte order.  The file starts with a DailyRecordHeader.
+struct DailyRecordHeader {
+    char magic[8];                                                    // "DENDAILY"
+    uint32_t version;
+    uint32_t record_size;                                             // sizeof(DailyRecord)
+    uint64_t serial;
+};
+
+struct DailyRecord {
+    int32_t day;
+    int32_t incidence[NUM_OF_INCIDENCE_REPORTING_TYPES];
+    int32_t prevalence[NUM_OF_PREVALENCE_REPORTING_TYPES];
+    float expected_eip;
+    float mosquito_capacity;                                          // multiplier * default capacity
+};
+
+// Where periodic output goes for the current run: text to stderr, or to <dailyOutputFilename>.<process id>;
+// with -binarydailyoutput, daily records to that file and the rest to stderr
+struct PeriodicOutput {
+    string process_id;
+    unique_ptr<OutputSink> text;
+    unique_ptr<OutputSink> records;                                   // null unless binary
+} PERIODIC_OUTPUT;
+
+// Records kept for the current run, attached to the community being simulated: with -infectionlogfile, the
+// infection line list, <infectionLogFilename>.<process id>; with -transmissionchainfile, who infected whom,
+// <transmissionChainFilename>.<process id>; with -rasterfile, weekly or monthly incidence maps,
+// <rasterFilename>.<process id>
+struct RunRecorders {
+    Community* community;
+    string process_id;
+    unique_ptr<InfectionLog> infection_log;
+    unique_ptr<TransmissionChain> chain;
+    unique_ptr<IncidenceRaster> raster;
+} RUN_RECORDERS;
+
 // Predeclare local functions
 Community* build_community(const Parameters* par);
 void seed_epidemic(const Parameters* par, Community* community);
@@ -109,24 +156,41 @@ vector<int> simulate_epidemic(const Parameters* par, Community* community, const
 void write_immunity_file(const Community* community, const string label, string filename, int runLength);
 void write_immunity_by_age_file(const Community* community, const int year, string filename="");
 void write_daily_buffer( vector<string>& buffer, const string process_id, string filename);
+void report_memory_usage(ostream& os, const Community* community, const string process_id, const string when);
 
 Community* build_community(const Parameters* par) {
+    INSTRUMENT_TRACE_CONFIGURE(par->traceFilename, par->traceSamplingInterval, par->traceMaxEvents);
     Community* community = new Community(par);
     Person::setPar(par);
 
-    if (!community->loadLocations(par->locationFilename, par->networkFilename)) {
-        cerr << "ERROR: Could not load locations" << endl;
-        exit(-1);
+    {
+        INSTRUMENT_IO("load locations: " + par->locationFilename);
+        if (!community->loadLocations(par->locationFilename, par->networkFilename)) {
+            cerr << "ERROR: Could not load locations" << endl;
+            exit(-1);
+        }
     }
-    if (!community->loadPopulation(par->populationFilename, par->immunityFilename, par->swapProbFilename)) {
-        cerr << "ERROR: Could not load population" << endl;
-        exit(-1);
+    {
+        INSTRUMENT_IO("load population: " + par->populationFilename);
+        if (!community->loadPopulation(par->populationFilename, par->immunityFilename, par->swapProbFilename)) {
+            cerr << "ERROR: Could not load population" << endl;
+            exit(-1);
+        }
     }
 
     if (!par->abcVerbose) {
         cerr << community->getNumPeople() << " people" << endl;
     }
 
+    if (par->forcingFilename.length() > 0) {
+        INSTRUMENT_IO("load forcing: " + par->forcingFilename);
+        if (par->regionFilename.length() > 0 and !community->loadRegions(par->regionFilename)) {
+            cerr << "ERROR: Could not load regions" << endl;
+            exit(-1);
+        }
+        community->setForcing(new Forcing(par->forcingFilename, par->startDayOfYear-1));
+    }
+
     if (!par->bSecondaryTransmission) {
         community->setNoSecondaryTransmission();
     }
@@ -164,6 +228,7 @@ void seed_epidemic(const Parameters* par, Community* community) {
 
 
 void write_yearly_people_file(const Parameters* par, const Community* community, int time) {
+    INSTRUMENT_IO("yearly people file");
     ofstream yearlyPeopleOutputFile;
     ostringstream ssFilename;
     ssFilename << par->yearlyPeopleOutputFilename << ((int)(time/365)) << ".csv";
@@ -193,9 +258,10 @@ void write_yearly_people_file(const Parameters* par, const Community* community,
 }
 
 void initialize_seasonality(const Parameters* par, Community* community, int& nextMosquitoMultiplierIndex, int& nextEIPindex, Date& date) {
+    const Forcing* forcing = community->getForcing();                 // forcing tables replace the global series
     const int mosquitoMultiplierTotalDuration = par->getMosquitoMultiplierTotalDuration();
     int currentDayOfYearOffset = 0;
-    if (mosquitoMultiplierTotalDuration > 0) {
+    if (mosquitoMultiplierTotalDuration > 0 and not (forcing and forcing->has(Forcing::CAPACITY))) {
         nextMosquitoMultiplierIndex = 0;
         while (currentDayOfYearOffset <= date.offset()) {
             currentDayOfYearOffset += par->mosquitoMultipliers[nextMosquitoMultiplierIndex].duration;
@@ -209,7 +275,7 @@ void initialize_seasonality(const Parameters* par, Community* community, int& ne
 
     const int EIPtotalDuration = par->getEIPtotalDuration();
     currentDayOfYearOffset = 0;
-    if (EIPtotalDuration > 0) {
+    if (EIPtotalDuration > 0 and not (forcing and forcing->has(Forcing::EIP))) {
         nextEIPindex = 0;
         while (currentDayOfYearOffset <= date.offset()) {
             currentDayOfYearOffset += par->extrinsicIncubationPeriods[nextEIPindex].duration;
@@ -240,12 +306,98 @@ void _reporter(stringstream& ss, map<string, vector<int> > &periodic_incidence,
 }
 
 
+void close_periodic_output() {                                        // flushes, and joins any writer threads
+    PERIODIC_OUTPUT.text.reset();
+    PERIODIC_OUTPUT.records.reset();
+    PERIODIC_OUTPUT.process_id = "";
+}
+
+
+void close_run_recorders() {                                          // the community must still exist
+    if (RUN_RECORDERS.infection_log) RUN_RECORDERS.community->removeObserver(RUN_RECORDERS.infection_log.get());
+    if (RUN_RECORDERS.chain) RUN_RECORDERS.community->setTransmissionChain(nullptr);
+    if (RUN_RECORDERS.raster) {
+        RUN_RECORDERS.raster->finish();
+        RUN_RECORDERS.community->removeObserver(RUN_RECORDERS.raster.get());
+    }
+    RUN_RECORDERS.infection_log.reset();
+    RUN_RECORDERS.chain.reset();
+    RUN_RECORDERS.raster.reset();
+    RUN_RECORDERS.community = nullptr;
+    RUN_RECORDERS.process_id = "";
+}
+
+
+void close_run_output() {
+    close_periodic_output();
+    close_run_recorders();
+}
+
+
+void open_run_recorders(const Parameters* par, Community* community, const string process_id) {
+    RUN_RECORDERS.infection_log.reset();                              // an earlier run's community may be gone
+    RUN_RECORDERS.chain.reset();
+    RUN_RECORDERS.raster.reset();
+    RUN_RECORDERS.community = community;
+    RUN_RECORDERS.process_id = process_id;
+    if (par->infectionLogFilename.length() > 0) {
+        OutputSink* file = new FileSink(par->infectionLogFilename + "." + process_id, true);
+        RUN_RECORDERS.infection_log.reset(new InfectionLog(par->asyncOutput ? new AsyncWriter(file) : file, par->serial));
+        community->addObserver(RUN_RECORDERS.infection_log.get());
+    }
+    if (par->transmissionChainFilename.length() > 0) {
+        OutputSink* file = new FileSink(par->transmissionChainFilename + "." + process_id, true);
+        RUN_RECORDERS.chain.reset(new TransmissionChain(par->asyncOutput ? new AsyncWriter(file) : file, par->serial));
+        community->setTransmissionChain(RUN_RECORDERS.chain.get());
+    }
+    if (par->rasterFilename.length() > 0) {
+        OutputSink* file = new FileSink(par->rasterFilename + "." + process_id);
+        RUN_RECORDERS.raster.reset(new IncidenceRaster(community->getLocations(), par->rasterCellSize, par->asyncOutput ? new AsyncWriter(file) : file));
+        community->addObserver(RUN_RECORDERS.raster.get());
+    }
+}
+
+
+bool run_recorders_wanted(const Parameters* par) {
+    return par->infectionLogFilename.length() > 0 or par->transmissionChainFilename.length() > 0 or par->rasterFilename.length() > 0;
+}
+
+
+void open_periodic_output(const Parameters* par, const string process_id) {
+    close_periodic_output();
+    PERIODIC_OUTPUT.process_id = process_id;
+    OutputSink* text = nullptr;
+    if (par->dailyOutputFilename.length() > 0) {
+        const string filename = par->dailyOutputFilename + "." + process_id;
+        OutputSink* file = new FileSink(filename, par->binaryDailyOutput);
+        if (par->binaryDailyOutput) {
+            DailyRecordHeader header = {{'D', 'E', 'N', 'D', 'A', 'I', 'L', 'Y'}, 1, sizeof(DailyRecord), par->serial};
+            file->write((const char*) &header, sizeof(header));
+            PERIODIC_OUTPUT.records.reset(par->asyncOutput ? new AsyncWriter(file) : file);
+        } else {
+            text = file;
+        }
+    }
+    if (not text) text = new FileSink(stderr);
+    PERIODIC_OUTPUT.text.reset(par->asyncOutput ? new AsyncWriter(text) : text);
+}
+
+
 void periodic_output(const Parameters* par, const Community* community, map<string, vector<int> > &periodic_incidence, vector<int> &periodic_prevalence, const Date& date, const string process_id, vector<int>& proto_metrics) {
+    if (not PERIODIC_OUTPUT.text or PERIODIC_OUTPUT.process_id != process_id) open_periodic_output(par, process_id);
     stringstream ss;
 //if (date.day() >= 25*365 and date.day() < 36*365) {
 //if (date.day() >= 116*365) {                         // daily output starting in 1995, assuming Jan 1, 1879 simulation start
 //if (date.day() >= 99*365 and date.day() < 105*365) { // daily output for summer/winter IRS comparison
-    if (par->dailyOutput) {
+    if (par->dailyOutput and PERIODIC_OUTPUT.records) {
+        DailyRecord r;
+        r.day = date.day();
+        for (int i = 0; i < NUM_OF_INCIDENCE_REPORTING_TYPES; ++i) r.incidence[i] = periodic_incidence["daily"][i];
+        for (int i = 0; i < NUM_OF_PREVALENCE_REPORTING_TYPES; ++i) r.prevalence[i] = periodic_prevalence[i];
+        r.expected_eip = community->getExpectedExtrinsicIncubation();
+        r.mosquito_capacity = community->getMosquitoMultiplier()*par->nDefaultMosquitoCapacity;
+        PERIODIC_OUTPUT.records->write((const char*) &r, sizeof(r));
+    } else if (par->dailyOutput) {
         _reporter(ss, periodic_incidence, periodic_prevalence, par, process_id, " day: ", date.day(), "daily");
         ss << community->getExpectedExtrinsicIncubation() << " " << community->getMosquitoMultiplier()*par->nDefaultMosquitoCapacity << endl;
     }
@@ -323,6 +475,8 @@ void periodic_output(const Parameters* par, const Community* community, map<stri
 
         if (par->yearlyPeopleOutputFilename.length() > 0) write_yearly_people_file(par, community, date.day());
 
+        INSTRUMENT_REPORT(ss, process_id, date.year());
+        if (par->memoryReport) report_memory_usage(ss, community, process_id, "year " + to_string(date.year()));
     }
 
     periodic_incidence["daily"] = vector<int>(NUM_OF_INCIDENCE_REPORTING_TYPES, 0);
@@ -333,9 +487,8 @@ void periodic_output(const Parameters* par, const Community* community, map<stri
 
     periodic_prevalence         = vector<int>(NUM_OF_PREVALENCE_REPORTING_TYPES, 0);
 
-    string output = ss.str();
-    fputs(output.c_str(), stderr);
-    //fputs(output.c_str(), stdout);
+    INSTRUMENT_FLUSH("periodic output");
+    PERIODIC_OUTPUT.text->write(ss.str());
 }
 
 void update_vaccinations(const Parameters* par, Community* community, const Date &date) {
@@ -345,7 +498,8 @@ void update_vaccinations(const Parameters* par, Community* community, const Date
     for (CatchupVaccinationEvent cve: par->catchupVaccinationEvents) {
         // Normal, initial vaccination -- boosting, multiple doses handled in Community::tick()
         if (date.day() == cve.simDay) {
-            if (not par->abcVerbose) cerr << "vaccinating " << cve.coverage*100 << "% of age " << cve.age << " on day " << cve.simDay << endl;
+            if (not par->abcVerbose) cerr << "vaccinating " << cve.coverage*100 << "% of age " << cve.age << " on day " << cve.simDay
+                                          << (cve.rolloutDuration > 1 ? " over " + to_string(cve.rolloutDuration) + " days" : "") << endl;
             community->vaccinate(cve);
         }
     }
@@ -362,7 +516,7 @@ void schedule_vector_control(const Parameters* par, Community* community) {
                 if (loc->getType() == vce.locationType and  gsl_rng_uniform(RNG) < vce.coverage) {
                    // location will be treated
                    const int loc_treatment_date = vce.campaignStart + gsl_rng_uniform_int(RNG, vce.campaignDuration);
-                   loc->scheduleVectorControlEvent(vce.efficacy, rho, loc_treatment_date, vce.efficacyDuration);
+                   community->scheduleVectorControl(loc, vce.efficacy, rho, loc_treatment_date, vce.efficacyDuration);
                 }
             }
         } else if (vce.strategy == TIRS_STUDY_STRATEGY) {
@@ -370,12 +524,12 @@ void schedule_vector_control(const Parameters* par, Community* community) {
                 if (loc->getType() == vce.locationType and loc->getTrialArm() == 2) {
                    // location will be treated
                    const int loc_treatment_date = vce.campaignStart + gsl_rng_uniform_int(RNG, vce.campaignDuration);
-                   loc->scheduleVectorControlEvent(vce.efficacy, rho, loc_treatment_date, vce.efficacyDuration);
+                   community->scheduleVectorControl(loc, vce.efficacy, rho, loc_treatment_date, vce.efficacyDuration);
                 }
             }
-        } else if (vce.strategy == MAX_MOSQUITOES_STRATEGY) { //  TODO - implement me
-            cerr << "ERROR: MAX_MOSQUITOES_STRATEGY is not yet implemented\n";
-            exit(-831);
+        } else if (vce.strategy == MAX_MOSQUITOES_STRATEGY) {
+            // locations are chosen daily during the campaign, by current mosquito burden
+            community->scheduleTargetedVectorControl(vce, rho);
         } else {
             cerr << "ERROR: Unsupported vector control strategy\n";
             exit(-832);
@@ -411,7 +565,8 @@ int seed_epidemic(const Parameters* par, Community* community, const Date &date)
 
 void update_mosquito_population(const Parameters* par, Community* community, const Date &date, int& nextMosquitoMultiplierIndex) {
     const int mosquitoMultiplierTotalDuration = par->getMosquitoMultiplierTotalDuration();
-    // should the mosquito population change?
+    // should the mosquito population change?  (every day, in Community::tick(), with a capacity forcing table)
+    if (community->getForcing() and community->getForcing()->has(Forcing::CAPACITY)) return;
     if (par->mosquitoMultipliers.size() > 0) {
         const int nextMosquitoStart = par->mosquitoMultipliers[nextMosquitoMultiplierIndex].start;
         if ( ((date.day()+date.offset())%mosquitoMultiplierTotalDuration) == nextMosquitoStart) {
@@ -426,6 +581,7 @@ void update_mosquito_population(const Parameters* par, Community* community, con
 
 void update_extrinsic_incubation_period(const Parameters* par, Community* community, const Date &date, int& nextEIPindex) {
     // should the EIP change?
+    if (community->getForcing() and community->getForcing()->has(Forcing::EIP)) return;
     const int EIPtotalDuration = par->getEIPtotalDuration();
     if (par->extrinsicIncubationPeriods.size() > 0) {
         const int nextEIPstart = par->extrinsicIncubationPeriods[nextEIPindex].start;
@@ -438,12 +594,22 @@ void update_extrinsic_incubation_period(const Parameters* par, Community* commun
 
 
 void advance_simulator(const Parameters* par, Community* community, Date &date, const string process_id, map<string, vector<int> > &periodic_incidence, vector<int> &periodic_prevalence, int &nextMosquitoMultiplierIndex, int &nextEIPindex, vector<int> &proto_metrics) {
-    update_mosquito_population(par, community, date, nextMosquitoMultiplierIndex);
-    update_extrinsic_incubation_period(par, community, date, nextEIPindex);
+    INSTRUMENT_DAY(date.day());
+    {
+        INSTRUMENT_PHASE(SEASONALITY);
+        update_mosquito_population(par, community, date, nextMosquitoMultiplierIndex);
+        update_extrinsic_incubation_period(par, community, date, nextEIPindex);
+    }
+    if (run_recorders_wanted(par) and (RUN_RECORDERS.community != community or RUN_RECORDERS.process_id != process_id)) {
+        open_run_recorders(par, community, process_id);
+    }
     community->tick(date);
 
     seed_epidemic(par, community, date);
 
+    INSTRUMENT_PHASE(REPORTING);
+    if (RUN_RECORDERS.raster and (par->monthlyRaster ? date.endOfMonth() : date.endOfWeek())) RUN_RECORDERS.raster->endFrame(date.day());
+
     for (Person* p: community->getPeople()) {
         if (p->isInfected(date.day())) {
             const Infection* infec = p->getInfection();
@@ -526,6 +692,8 @@ vector<int> simulate_epidemic_with_seroprev(const Parameters* par, Community* co
     int nextEIPindex = 0;
 
     initialize_seasonality(par, community, nextMosquitoMultiplierIndex, nextEIPindex, date);
+    INSTRUMENT_RNG(RNG);
+    if (par->memoryReport) report_memory_usage(cerr, community, process_id, "load");
     schedule_vector_control(par, community);
     vector<string> daily_output_buffer;
 
@@ -560,6 +728,8 @@ vector<int> simulate_epidemic_with_seroprev(const Parameters* par, Community* co
     string dailyfilename = ss_filename.str();
     write_daily_buffer(daily_output_buffer, process_id, dailyfilename);
 */
+    close_run_output();
+    INSTRUMENT_TRACE_WRITE(process_id);
     return proto_metrics;
 }
 
@@ -580,6 +750,8 @@ vector<long double> simulate_who_fitting(const Parameters* par, Community* commu
     int nextEIPindex = 0;
 
     initialize_seasonality(par, community, nextMosquitoMultiplierIndex, nextEIPindex, date);
+    INSTRUMENT_RNG(RNG);
+    if (par->memoryReport) report_memory_usage(cerr, community, process_id, "load");
     vector<string> daily_output_buffer;
 
     if (par->bSecondaryTransmission and not par->abcVerbose) {
@@ -606,12 +778,36 @@ vector<long double> simulate_who_fitting(const Parameters* par, Community* commu
         advance_simulator(par, community, date, process_id, periodic_incidence, periodic_prevalence, nextMosquitoMultiplierIndex, nextEIPindex, proto_metrics);
     }
 
+    close_run_output();
+    INSTRUMENT_TRACE_WRITE(process_id);
     return metrics;
 }
 
+// Early rejection of ABC particles: an experiment registers checkpoints whose predicates test partial metrics
+// (a serosurvey result, cumulative cases by a given year, epidemic timing), e.g. through the observers in
+// Metrics.h.  A checkpoint is tested at the end of its date; if accept() returns false, simulate_abc() stops there
+// and the experiment returns abc_rejection_metrics() in place of its metrics.
+struct AbcCheckpoint {
+    string name;                                                      // reported on rejection
+    int year;                                                         // as Date::year(), i.e. counting from 0
+    int julian_day;                                                   // as Date::julianDay()
+    function<bool()> accept;
+};
+
+// NaN in every position; experiments replace non-finite metrics, so this cannot be a real particle's result
+vector<double> abc_rejection_metrics(size_t num_metrics) { return vector<double>(num_metrics, numeric_limits<double>::quiet_NaN()); }
+
+bool is_abc_rejection(const vector<double> &metrics) {
+    for (double m: metrics) if (not std::isnan(m)) return false;
+    return metrics.size() > 0;
+}
+
 //c('0-4', '5-9', '10-14', '15-19', '20-29', '30-39', '40-49', '50-59', '60+')
 
-vector<int> simulate_abc(const Parameters* par, Community* community, const string process_id, vector<int> &serotested_ids_87, double &seropos_87, vector<int> &serotested_ids_14, vector<double> &seropos_14_by_age) {
+// rejected_by is set to the index of the failed checkpoint, or -1 if the run was completed
+vector<int> simulate_abc(const Parameters* par, Community* community, const string process_id, vector<int> &serotested_ids_87, double &seropos_87, vector<int> &serotested_ids_14, vector<double> &seropos_14_by_age, const vector<AbcCheckpoint> &checkpoints, int &rejected_by) {
+    rejected_by = -1;
+    vector<bool> checked(checkpoints.size(), false);
     assert(serotested_ids_87.size() > 0);
     vector<int> proto_metrics;
     Date date(par);
@@ -619,6 +815,8 @@ vector<int> simulate_abc(const Parameters* par, Community* community, const stri
     int nextEIPindex = 0;
 
     initialize_seasonality(par, community, nextMosquitoMultiplierIndex, nextEIPindex, date);
+    INSTRUMENT_RNG(RNG);
+    if (par->memoryReport) report_memory_usage(cerr, community, process_id, "load");
     vector<string> daily_output_buffer;
 
     if (par->bSecondaryTransmission and not par->abcVerbose) {
@@ -661,6 +859,19 @@ vector<int> simulate_abc(const Parameters* par, Community* community, const stri
         }
         advance_simulator(par, community, date, process_id, periodic_incidence, periodic_prevalence, nextMosquitoMultiplierIndex, nextEIPindex, proto_metrics);
 
+        for (unsigned int i = 0; i < checkpoints.size(); ++i) {
+            const AbcCheckpoint &cp = checkpoints[i];
+            if (checked[i] or (int) date.year() < cp.year or ((int) date.year() == cp.year and (int) date.julianDay() < cp.julian_day)) continue;
+            checked[i] = true;
+            if (not cp.accept()) {
+                cerr << "rejected at " << cp.name << " checkpoint, day " << date.day() << " of " << par->nRunLength << endl;
+                rejected_by = i;
+                close_run_output();
+                INSTRUMENT_TRACE_WRITE(process_id);
+                return proto_metrics;
+            }
+        }
+
 /*        if ( date.julianDay() == 365 and date.year() == 121 ) { // December 31 (day 365) of 2000
             string imm_filename = "/ufrc/longini/tjhladish/imm_1000_yucatan-irs_refit/immunity2000." + process_id;
             write_immunity_file(community, process_id, imm_filename, date.day());
@@ -675,10 +886,30 @@ vector<int> simulate_abc(const Parameters* par, Community* community, const stri
     //string dailyfilename = "";
     //write_daily_buffer(daily_output_buffer, process_id, dailyfilename);
 
+    close_run_output();
+    INSTRUMENT_TRACE_WRITE(process_id);
     return proto_metrics;
 }
 
 
+vector<int> simulate_abc(const Parameters* par, Community* community, const string process_id, vector<int> &serotested_ids_87, double &seropos_87, vector<int> &serotested_ids_14, vector<double> &seropos_14_by_age) {
+    int rejected_by;
+    return simulate_abc(par, community, process_id, serotested_ids_87, seropos_87, serotested_ids_14, seropos_14_by_age, vector<AbcCheckpoint>(), rejected_by);
+}
+
+
+// One line of estimated bytes by subsystem, plus what the OS reports
+void report_memory_usage(ostream& os, const Community* community, const string process_id, const string when) {
+    const vector< pair<string, size_t> > usage = community->getMemoryUsage();
+    size_t total = 0;
+    for (const auto &u: usage) total += u.second;
+    os << process_id << " memory " << when << ": total=" << total;
+    for (const auto &u: usage) os << " " << u.first << "=" << u.second;
+    os << " live_mosquitoes=" << community->getNumLiveMosquitoes()
+       << " vm_rss_kb=" << dengue::util::getProcStatusKB("VmRSS") << " vm_size_kb=" << dengue::util::getProcStatusKB("VmSize") << endl;
+}
+
+
 bool fileExists(const std::string& filename) {
     struct stat buf;
     return stat(filename.c_str(), &buf) != -1;
@@ -686,29 +917,22 @@ bool fileExists(const std::string& filename) {
 
 
 void write_daily_buffer( vector<string>& buffer, const string process_id, string filename = "" ) {
+    INSTRUMENT_IO("daily buffer");
     if (filename == "") {
         stringstream ss_filename;
         ss_filename << "daily_output." << process_id;
         filename = ss_filename.str();
     }
 
-    string all_output;
-    for (const auto &line : buffer) all_output += (line + "\n");
-
     if (fileExists(filename)) {
         cerr << "WARNING: Daily output file already exists: " << filename << endl << "WARNING: Aborting write.\n";
         return;
     }
 
-    ofstream file;
-    file.open(filename);
-
-    if (file.is_open()) {  // TODO - add this check everywhere a file is opened
-        file << all_output;
-        file.close();
-    } else {
-        cerr << "ERROR: Could not open daily buffer file for output: " << filename << endl;
-        exit(-842);
+    FileSink file(filename);                                          // streamed line by line, not joined first
+    for (const auto &line : buffer) {
+        file.write(line);
+        file.write("\n", 1);
     }
 }
 
@@ -745,6 +969,7 @@ void write_immunity_by_age_file(const Community* community, const int year, stri
 
 
 void write_immunity_file(const Community* community, const string label, string filename, int runLength) {
+    INSTRUMENT_IO("checkpoint: immunity " + filename);
     if (filename == "") {
         stringstream ss_filename;
         ss_filename << "immunity." << label;
@@ -797,6 +1022,7 @@ void daily_detailed_output(Community* community, int t) {
 
 
 void write_mosquito_location_data(const Community* community, string mos_filename, string loc_filename) {
+    INSTRUMENT_IO("checkpoint: mosquitoes " + mos_filename);
     ofstream mos_file;
     mos_file.open(mos_filename);
     mos_file << "locID sero queue idx ageInfd ageInfs ageDead\n";
@@ -835,72 +1061,3 @@ void write_mosquito_location_data(const Community* community, string mos_filenam
     }
     loc_file.close();
 }
-
-void import_csv_to_db(string filename, string table, string db) {
-    stringstream ss;
-    ss << "sqlite3 " << db << " '.mode csv' '.import " << filename << ' ' << table << "'";
-    string cmd_str = ss.str();
-    int retval = system(cmd_str.c_str());
-    if (retval == -1) { cerr << "System failed to import " << table << " data to db\n"; }
-    return;
-}
-
-void generate_sim_data_db(const Parameters* par, const Community* community, const unsigned long int serial, vector<string> tables) {
-    vector<stringstream> filenames(tables.size());
-    for (size_t i = 0; i < tables.size(); ++i) {
-        filenames[i] << "./" << tables[i] << "_" << serial << ".csv";
-    }
-
-    map<string, ofstream> ofiles;
-    for (size_t i = 0; i < tables.size(); ++i) {
-        ofiles[tables[i]] = ofstream(filenames[i].str(), std::ios::trunc);
-    }
-
-    bool all_files_open = true;
-    for (const auto& [table, ofile] : ofiles) {
-        all_files_open = all_files_open and (bool)ofile;
-    }
-    if (not all_files_open) { cerr << "FILES FAILED TO OPEN" << endl; exit(-1); }
-
-    for (Person* p : community->getPeople()) {
-        for (Infection* inf : p->getInfectionHistory()) {
-            if (not inf) { continue; }
-            int inf_place_id = inf->getInfectedLoc() ? inf->getInfectedLoc()->getID() : -1;
-            int inf_by_id    = inf->getInfectedBy() ? inf->getInfectedBy()->getID() : -1;
-            int inf_owner_id = inf->getInfectionOwner() ? inf->getInfectionOwner()->getID() : -1;
-
-            ofiles["infection_history"] << inf << ','
-                                        << inf_place_id << ','
-                                        << inf_by_id << ','
-                                        << inf_owner_id << ','
-                                        << inf->getInfectedTime() << ','
-                                        << inf->getInfectiousTime() << ','
-                                        << inf->getSymptomTime() << ','
-                                        << inf->getRecoveryTime() << ','
-                                        << inf->getWithdrawnTime() << ','
-                                        << inf->isSevere() << ','
-                                        << inf->serotype() << endl;
-        }
-    }
-    for (auto& [table, ofile] : ofiles) { ofile.close(); }
-
-    stringstream ss, db;
-    db << "sim_data_" << serial << ".sqlite";
-    ss << "sqlite3 " << db.str() << " '.read gen_sim_db.sql'";
-
-    string cmd_str = ss.str();
-    int retval = system(cmd_str.c_str());
-    if (retval == -1) { cerr << "System call to `sqlite3 " << db.str() << " '.read gen_sim_db.sql'` failed\n"; }
-
-    for (size_t i = 0; i < tables.size(); ++i) {
-        import_csv_to_db(filenames[i].str(), tables[i], db.str());
-    }
-
-    ss.str(string());
-    ss << "rm";
-    for (size_t i = 0; i < filenames.size(); ++i) { ss << ' ' << filenames[i].str(); }
-
-    cmd_str = ss.str();
-    retval = system(cmd_str.c_str());
-    if (retval == -1) { cerr << "System call to delete infection csv files failed\n"; }
-}
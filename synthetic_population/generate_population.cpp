@@ -0,0 +1,435 @@
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <queue>
+#include <random>
+#include <algorithm>
+#include <assert.h>
+
+/******************************************************************************
+
+    Generates a synthetic population of any size (10^5 to 10^8+ people) in the
+    format read by Community::loadLocations() and loadPopulation(), for
+    benchmarking load time, memory and throughput as the population scales.
+
+    Writes <dir>/population-<name>.txt, locations-<name>.txt,
+    network-<name>.txt, immunity-<name>.txt, and swap_probabilities-<name>.txt.
+
+    - People live in households with Yucatan-like sizes (1-9, mean ~3.7),
+      built around a head of household, possibly a partner, children, and
+      other adults, so ages within a household are plausible.
+    - Households cluster in settlements with Zipf-distributed sizes, placed
+      at ~100 people/km^2 overall (Gaussian cores of ~3000 people/km^2),
+      around the Yucatan, in longitude/latitude.
+    - School-age children attend the nearest school (~300 students); 60% of
+      adults 18-64 work, at workplaces with a heavy-tailed (lognormal) size
+      distribution, chosen near a commute-distance target and weighted by
+      size.  Schools get one teacher per 28 students.
+    - The location network is a Yao graph: each location is linked to its
+      nearest location in each of six 60-degree sectors (among its 16 nearest
+      locations), which, like a Delaunay triangulation, gives a connected,
+      planar-like graph with mean degree ~6.
+    - Initial immunity assumes a constant force of infection per serotype;
+      swap probabilities link each person to the nearest people one year
+      younger, weighted by inverse squared distance, as
+      immunity_swapping/determine_immunity_swap_probs.cpp does.
+
+    Usage: ./generate_population -n <people> [-name synthetic] [-dir .]
+           [-seed 1] [-foi 0.03] [-swapneighbors 3] [-noswap] [-noimmunity]
+
+******************************************************************************/
+
+using namespace std;
+
+const double KM_PER_DEG_LAT  = 111.32;
+const double CENTER_LON      = -89.62;   // Merida
+const double CENTER_LAT      = 20.97;
+const double REGION_DENSITY  = 100.0;    // people per km^2, overall
+const double CORE_DENSITY    = 3000.0;   // people per km^2, at the center of a settlement
+const int    PEOPLE_PER_SETTLEMENT = 20000;
+const int    MAX_AGE         = 100;
+const vector<double> HOUSEHOLD_SIZE_PROBS = {0.09, 0.19, 0.20, 0.22, 0.15, 0.08, 0.04, 0.02, 0.01}; // sizes 1-9
+const double SCHOOL_SIZE     = 300;
+const double STUDENT_TEACHER_RATIO = 28;
+const double EMPLOYMENT_RATE = 0.6;
+const double WORKPLACE_LOG_MEAN = 1.0;   // lognormal workplace capacity: median ~3, mean ~6
+const double WORKPLACE_LOG_SD   = 1.3;
+const double MEAN_COMMUTE_KM = 3.0;
+const int    WORKPLACE_CHOICES = 8;      // nearest workplaces to a commute target to choose among
+const int    YAO_SECTORS     = 6;
+const int    YAO_CANDIDATES  = 16;
+const double MIN_DISPLACEMENT = 0.005;   // km; distance used between people who live in the same house
+const size_t CHUNK = 1 << 20;            // items per parallel block
+
+enum DayType { STAYS_HOME, WORKS, STUDIES };
+
+// Uniform grid over points in the plane (km), for k-nearest queries
+class PointGrid {
+    public:
+        void build(const vector<float>& xs, const vector<float>& ys, const vector<int>& ids, double points_per_cell = 2.0) {
+            _ids.clear(); _cellStart.clear(); _nx = _ny = 0;
+            if (ids.size() == 0) return;
+            float x_max = xs[ids[0]], y_max = ys[ids[0]];
+            _xMin = x_max; _yMin = y_max;
+            for (int i: ids) {
+                _xMin = min(_xMin, xs[i]); x_max = max(x_max, xs[i]);
+                _yMin = min(_yMin, ys[i]); y_max = max(y_max, ys[i]);
+            }
+            const double w = max(x_max - _xMin, 1e-3f), h = max(y_max - _yMin, 1e-3f);
+            _cell = max(sqrt(w * h * points_per_cell / ids.size()), max(w, h) / 16384);
+            _nx = (int) (w / _cell) + 1;
+            _ny = (int) (h / _cell) + 1;
+            _cellStart.assign((size_t) _nx * _ny + 1, 0);
+            for (int i: ids) ++_cellStart[_cellOf(xs[i], ys[i]) + 1];
+            for (size_t c = 1; c < _cellStart.size(); ++c) _cellStart[c] += _cellStart[c-1];
+            vector<uint32_t> fill(_cellStart.begin(), _cellStart.end() - 1);
+            _ids.resize(ids.size());
+            _x.resize(ids.size());
+            _y.resize(ids.size());
+            for (int i: ids) {
+                const size_t pos = fill[_cellOf(xs[i], ys[i])]++;
+                _ids[pos] = i; _x[pos] = xs[i]; _y[pos] = ys[i];
+            }
+        }
+
+        bool empty() const { return _ids.size() == 0; }
+
+        // the k points nearest (x, y), nearest first, as (distance, id); points outside the grid are moved to its edge
+        void nearest(double x, double y, unsigned int k, vector<pair<float, int> >& result) const {
+            nearest(x, y, k, result, [](int) { return true; });
+        }
+
+        // the same, among points for which eligible(id) is true
+        template <typename Predicate>
+        void nearest(double x, double y, unsigned int k, vector<pair<float, int> >& result, Predicate eligible) const {
+            result.clear();
+            if (_ids.size() == 0 or k == 0) return;
+            x = min(max(x, (double) _xMin), _xMin + _nx * _cell);
+            y = min(max(y, (double) _yMin), _yMin + _ny * _cell);
+            priority_queue<pair<float, int> > best;                  // farthest on top
+            const int cx = _clamp((int) floor((x - _xMin) / _cell), _nx);
+            const int cy = _clamp((int) floor((y - _yMin) / _cell), _ny);
+            const int max_ring = max(max(cx, _nx - 1 - cx), max(cy, _ny - 1 - cy));
+            for (int ring = 0; ring <= max_ring; ++ring) {
+                if (best.size() == k and best.top().first < (ring - 1) * _cell) break;
+                for (int gy = cy - ring; gy <= cy + ring; ++gy) {
+                    if (gy < 0 or gy >= _ny) continue;
+                    const bool edge_row = (gy == cy - ring or gy == cy + ring);
+                    for (int gx = cx - ring; gx <= cx + ring; gx += (edge_row ? 1 : 2*ring)) {
+                        if (gx < 0 or gx >= _nx) continue;
+                        const size_t c = (size_t) gy * _nx + gx;
+                        for (uint32_t i = _cellStart[c]; i < _cellStart[c+1]; ++i) {
+                            if (not eligible(_ids[i])) continue;
+                            const pair<float, int> cand(hypot(_x[i] - x, _y[i] - y), _ids[i]);
+                            if (best.size() < k) best.push(cand);
+                            else if (cand < best.top()) { best.pop(); best.push(cand); }
+                        }
+                    }
+                }
+            }
+            result.resize(best.size());
+            for (int i = result.size() - 1; i >= 0; --i) { result[i] = best.top(); best.pop(); }
+        }
+
+    private:
+        float _xMin, _yMin;
+        double _cell;
+        int _nx, _ny;
+        vector<uint32_t> _cellStart;
+        vector<int> _ids;
+        vector<float> _x, _y;
+
+        static int _clamp(int i, int n) { return i < 0 ? 0 : i >= n ? n - 1 : i; }
+        size_t _cellOf(double x, double y) const {
+            return (size_t) _clamp((int) ((y - _yMin) / _cell), _ny) * _nx + _clamp((int) ((x - _xMin) / _cell), _nx);
+        }
+};
+
+void usage() {
+    cerr << "\n\tUsage: ./generate_population -n <people> [-name synthetic] [-dir .] [-seed 1] [-foi 0.03]\n"
+         << "\t                             [-swapneighbors 3] [-noswap] [-noimmunity]\n\n";
+    exit(-5);
+}
+
+ofstream open_output(const string filename) {
+    ofstream out(filename.c_str());
+    if (not out) {
+        cerr << "ERROR: Could not open " << filename << " for output" << endl;
+        exit(-1);
+    }
+    return out;
+}
+
+int main(int argc, char** argv) {
+    long long num_people = 0;
+    string name = "synthetic";
+    string dir = ".";
+    unsigned long seed = 1;
+    double foi = 0.03;                                                // per serotype per year
+    int swap_neighbors = 3;
+    bool write_swap = true;
+    bool write_immunity = true;
+    for (int i = 1; i < argc; ++i) {
+        const string opt = argv[i];
+        if (opt == "-noswap") { write_swap = false; continue; }
+        if (opt == "-noimmunity") { write_immunity = false; continue; }
+        if (i + 1 >= argc) usage();
+        const char* val = argv[++i];
+        if      (opt == "-n")    num_people = atoll(val);
+        else if (opt == "-name") name = val;
+        else if (opt == "-dir")  dir = val;
+        else if (opt == "-seed") seed = strtoul(val, nullptr, 10);
+        else if (opt == "-foi")  foi = atof(val);
+        else if (opt == "-swapneighbors") swap_neighbors = atoi(val);
+        else usage();
+    }
+    if (num_people < 1 or num_people > INT32_MAX or swap_neighbors < 1) usage();
+    const int N = num_people;
+    mt19937_64 rng(seed);
+    uniform_real_distribution<double> runif(0.0, 1.0);
+    normal_distribution<double> rnorm(0.0, 1.0);
+
+    // settlements: Zipf sizes, centers spread over a square region
+    const int num_settlements = max(1, N / PEOPLE_PER_SETTLEMENT);
+    const double region_side = sqrt(N / REGION_DENSITY);             // km
+    vector<double> settlement_cdf(num_settlements), settlement_x(num_settlements), settlement_y(num_settlements), settlement_sd(num_settlements);
+    double zipf_total = 0.0;
+    for (int s = 0; s < num_settlements; ++s) zipf_total += 1.0 / (s + 1);
+    for (int s = 0; s < num_settlements; ++s) {
+        const double share = 1.0 / (s + 1) / zipf_total;
+        settlement_cdf[s] = (s ? settlement_cdf[s-1] : 0.0) + share;
+        settlement_x[s] = (runif(rng) - 0.5) * region_side;
+        settlement_y[s] = (runif(rng) - 0.5) * region_side;
+        settlement_sd[s] = sqrt(share * N / (2 * M_PI * CORE_DENSITY));   // bivariate normal with this peak density
+    }
+    settlement_cdf.back() = 1.0;
+
+    // households and their members
+    vector<double> size_cdf(HOUSEHOLD_SIZE_PROBS.size());
+    partial_sum(HOUSEHOLD_SIZE_PROBS.begin(), HOUSEHOLD_SIZE_PROBS.end(), size_cdf.begin());
+    vector<float> hh_x, hh_y;                                         // km
+    vector<int> home(N);
+    vector<uint8_t> age(N), sex(N), day_type(N);
+    auto adult_age = [&](double mean, double sd) { return (uint8_t) min(MAX_AGE, max(18, (int) lround(mean + sd * rnorm(rng)))); };
+    long long num_students = 0, num_workers = 0;
+    for (int pid = 0; pid < N; ) {
+        const int hid = hh_x.size();
+        const int s = lower_bound(settlement_cdf.begin(), settlement_cdf.end(), runif(rng)) - settlement_cdf.begin();
+        hh_x.push_back(settlement_x[s] + settlement_sd[s] * rnorm(rng));
+        hh_y.push_back(settlement_y[s] + settlement_sd[s] * rnorm(rng));
+        const int size = min((int) (lower_bound(size_cdf.begin(), size_cdf.end(), runif(rng) * size_cdf.back()) - size_cdf.begin()) + 1, N - pid);
+        const int head_age = adult_age(45, 14);
+        for (int m = 0; m < size; ++m, ++pid) {
+            home[pid] = hid;
+            if (m == 0) {
+                age[pid] = head_age;
+                sex[pid] = runif(rng) < 0.5 ? 1 : 2;
+            } else if (m == 1 and runif(rng) < 0.85) {                // partner
+                age[pid] = adult_age(head_age, 4);
+                sex[pid] = runif(rng) < 0.9 ? 3 - sex[pid-m] : sex[pid-m];
+            } else if (runif(rng) < 0.8 and head_age >= 20) {         // child
+                age[pid] = (uint8_t) min(30, (int) (runif(rng) * (head_age - 17)));
+                sex[pid] = runif(rng) < 0.5 ? 1 : 2;
+            } else {                                                  // other relative
+                age[pid] = runif(rng) < 0.5 ? adult_age(head_age + 25, 6) : adult_age(head_age, 15);
+                sex[pid] = runif(rng) < 0.5 ? 1 : 2;
+            }
+            const int a = age[pid];
+            const double p_school = a < 5 ? 0.0 : a <= 14 ? 0.97 : a <= 17 ? 0.75 : 0.0;
+            if (runif(rng) < p_school) {
+                day_type[pid] = STUDIES; ++num_students;
+            } else if (a >= 18 and a <= 64 and runif(rng) < EMPLOYMENT_RATE) {
+                day_type[pid] = WORKS; ++num_workers;
+            } else {
+                day_type[pid] = STAYS_HOME;
+            }
+        }
+    }
+    const int num_households = hh_x.size();
+
+    // schools & workplaces, placed near random households so they follow population density
+    const int num_schools = max(1LL, llround(num_students / SCHOOL_SIZE));
+    const double teacher_fraction = min(1.0, num_students / STUDENT_TEACHER_RATIO / max(1LL, num_workers));
+    const double mean_capacity = exp(WORKPLACE_LOG_MEAN + WORKPLACE_LOG_SD * WORKPLACE_LOG_SD / 2);
+    const int num_workplaces = max(1LL, llround(num_workers * (1.0 - teacher_fraction) / mean_capacity));
+    vector<float> loc_x(hh_x), loc_y(hh_y);                           // all locations: households, workplaces, schools
+    vector<float> capacity(num_workplaces);
+    lognormal_distribution<double> rcapacity(WORKPLACE_LOG_MEAN, WORKPLACE_LOG_SD);
+    for (int w = 0; w < num_workplaces + num_schools; ++w) {
+        const int h = runif(rng) * num_households;
+        loc_x.push_back(hh_x[h] + 0.2 * rnorm(rng));
+        loc_y.push_back(hh_y[h] + 0.2 * rnorm(rng));
+        if (w < num_workplaces) capacity[w] = rcapacity(rng);
+    }
+    const int first_workplace = num_households;
+    const int first_school = num_households + num_workplaces;
+    const int num_locations = loc_x.size();
+    cerr << N << " people, " << num_households << " households, " << num_workplaces << " workplaces, " << num_schools << " schools" << endl;
+
+    vector<int> ids(num_workplaces);
+    PointGrid workplaces, schools;
+    for (int w = 0; w < num_workplaces; ++w) ids[w] = first_workplace + w;
+    workplaces.build(loc_x, loc_y, ids);
+    ids.resize(num_schools);
+    for (int s = 0; s < num_schools; ++s) ids[s] = first_school + s;
+    schools.build(loc_x, loc_y, ids);
+
+    // population file, with day locations
+    {
+        ofstream pop = open_output(dir + "/population-" + name + ".txt");
+        pop << "pid hid sex age did\n";
+        exponential_distribution<double> rcommute(1.0 / MEAN_COMMUTE_KM);
+        vector<pair<float, int> > near;
+        for (int pid = 0; pid < N; ++pid) {
+            const double x = hh_x[home[pid]], y = hh_y[home[pid]];
+            int did = -1;
+            if (day_type[pid] == STUDIES or (day_type[pid] == WORKS and runif(rng) < teacher_fraction)) {
+                schools.nearest(x, y, 1, near);
+                did = near[0].second;
+            } else if (day_type[pid] == WORKS) {
+                const double d = rcommute(rng), theta = 2 * M_PI * runif(rng);
+                workplaces.nearest(x + d * cos(theta), y + d * sin(theta), WORKPLACE_CHOICES, near);
+                double total = 0.0;
+                for (const auto &n: near) total += capacity[n.second - first_workplace];
+                double r = runif(rng) * total;
+                unsigned int i = 0;
+                while (i < near.size() - 1 and r >= capacity[near[i].second - first_workplace]) r -= capacity[near[i++].second - first_workplace];
+                did = near[i].second;
+            }
+            pop << pid << " " << home[pid] << " " << (int) sex[pid] << " " << (int) age[pid] << " " << did << "\n";
+        }
+    }
+
+    // locations file, in longitude/latitude
+    {
+        ofstream loc = open_output(dir + "/locations-" + name + ".txt");
+        loc << "id x y type arm surveilled\n" << fixed << setprecision(7);
+        const double km_per_deg_lon = KM_PER_DEG_LAT * cos(CENTER_LAT * M_PI / 180.0);
+        for (int l = 0; l < num_locations; ++l) {
+            const char type = l < first_workplace ? 'h' : l < first_school ? 'w' : 's';
+            loc << l << " " << CENTER_LON + loc_x[l] / km_per_deg_lon << " " << CENTER_LAT + loc_y[l] / KM_PER_DEG_LAT << " " << type << " 0 0\n";
+        }
+    }
+
+    // network file: Yao graph, computed in parallel blocks and written in order
+    {
+        ofstream net = open_output(dir + "/network-" + name + ".txt");
+        net << "locid1 locid2\n";
+        vector<int> all(num_locations);
+        for (int l = 0; l < num_locations; ++l) all[l] = l;
+        PointGrid grid;
+        grid.build(loc_x, loc_y, all);
+        vector<int> component(all);                                   // union-find, to make the graph connected
+        auto find = [&component](int l) {
+            while (component[l] != l) l = component[l] = component[component[l]];
+            return l;
+        };
+        auto link = [&](int a, int b) {
+            net << a << " " << b << "\n";                            // links are made symmetric on load
+            component[find(a)] = find(b);
+        };
+        vector<int> links;
+        for (size_t start = 0; start < (size_t) num_locations; start += CHUNK) {
+            const int end = min((size_t) num_locations, start + CHUNK);
+            links.assign((end - start) * YAO_SECTORS, -1);
+            #pragma omp parallel for schedule(dynamic, 1024)
+            for (int l = start; l < end; ++l) {
+                vector<pair<float, int> > near;
+                grid.nearest(loc_x[l], loc_y[l], YAO_CANDIDATES + 1, near);
+                for (const auto &n: near) {                           // nearest first, so the first hit in a sector wins
+                    if (n.second == l) continue;
+                    const double angle = atan2(loc_y[n.second] - loc_y[l], loc_x[n.second] - loc_x[l]) + M_PI;
+                    const int sector = min(YAO_SECTORS - 1, (int) (angle / (2 * M_PI) * YAO_SECTORS));
+                    int &link = links[(l - start) * YAO_SECTORS + sector];
+                    if (link == -1) link = n.second;
+                }
+            }
+            for (int l = start; l < end; ++l) {
+                for (int s = 0; s < YAO_SECTORS; ++s) {
+                    const int other = links[(l - start) * YAO_SECTORS + s];
+                    if (other >= 0) link(l, other);
+                }
+            }
+        }
+
+        // Candidate links only reach so far, so separate settlements may not be linked yet.  Borůvka-style rounds
+        // link each component to the nearest location outside it, via the closest pair found from one member.
+        vector<int> members;
+        while (true) {
+            members.clear();
+            vector<bool> seen(num_locations, false);
+            for (int l = 0; l < num_locations; ++l) {
+                const int root = find(l);
+                if (not seen[root]) { seen[root] = true; members.push_back(l); }
+            }
+            if (members.size() <= 1) break;
+            cerr << members.size() << " network components; linking" << endl;
+            vector<pair<float, int> > near;
+            for (int a: members) {
+                const int comp = find(a);
+                grid.nearest(loc_x[a], loc_y[a], 1, near, [&](int l) { return find(l) != comp; });
+                if (near.empty()) continue;
+                const int b = near[0].second;
+                grid.nearest(loc_x[b], loc_y[b], 1, near, [&](int l) { return find(l) == comp; });
+                link(near[0].second, b);
+            }
+        }
+    }
+
+    // immunity file: only people with past infections are listed
+    if (write_immunity) {
+        ofstream imm = open_output(dir + "/immunity-" + name + ".txt");
+        imm << "pid age imm1 imm2 imm3 imm4\n";
+        for (int pid = 0; pid < N; ++pid) {
+            int times[4] = {0, 0, 0, 0};
+            bool any = false;
+            for (int s = 0; s < 4; ++s) {
+                if (age[pid] > 0 and runif(rng) < 1.0 - exp(-foi * age[pid])) {
+                    times[s] = -1 - (int) (runif(rng) * (age[pid] * 365 - 1)); // days before the start of simulation
+                    any = true;
+                }
+            }
+            if (any) imm << pid << " " << (int) age[pid] << " " << times[0] << " " << times[1] << " " << times[2] << " " << times[3] << "\n";
+        }
+    }
+
+    // swap probabilities: nearest people one year younger
+    if (write_swap) {
+        ofstream swp = open_output(dir + "/swap_probabilities-" + name + ".txt");
+        vector<float> px(N), py(N);
+        for (int pid = 0; pid < N; ++pid) { px[pid] = hh_x[home[pid]]; py[pid] = hh_y[home[pid]]; }
+        vector< vector<int> > by_age(MAX_AGE + 1);
+        for (int pid = 0; pid < N; ++pid) by_age[age[pid]].push_back(pid);
+        vector<PointGrid> age_grids(MAX_AGE + 1);
+        for (int a = 0; a <= MAX_AGE; ++a) { age_grids[a].build(px, py, by_age[a]); vector<int>().swap(by_age[a]); }
+
+        vector<pair<float, int> > donors;
+        swp << fixed << setprecision(6);
+        for (size_t start = 0; start < (size_t) N; start += CHUNK) {
+            const int end = min((size_t) N, start + CHUNK);
+            vector< vector<pair<float, int> > > block(end - start);
+            #pragma omp parallel for schedule(dynamic, 1024)
+            for (int pid = start; pid < end; ++pid) {
+                int donor_age = age[pid] - 1;                         // nearest younger age, if no one is one year younger
+                while (donor_age >= 0 and age_grids[donor_age].empty()) --donor_age;
+                if (donor_age >= 0) age_grids[donor_age].nearest(px[pid], py[pid], swap_neighbors, block[pid - start]);
+            }
+            for (int pid = start; pid < end; ++pid) {
+                const vector<pair<float, int> > &near = block[pid - start];
+                double total = 0.0;
+                for (const auto &n: near) total += 1.0 / pow(max((double) n.first, MIN_DISPLACEMENT), 2);
+                for (const auto &n: near) {
+                    const double d = max((double) n.first, MIN_DISPLACEMENT);
+                    swp << pid << " " << n.second << " " << 1.0 / (d * d) / total << " " << d << "\n";
+                }
+            }
+        }
+    }
+    return 0;
+}